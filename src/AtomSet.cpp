@@ -0,0 +1,49 @@
+#include "AtomSet.h"
+#include "Atoms.h"
+
+Hash<xcb_atom_t, int> AtomSet::sIndices;
+xcb_atom_t AtomSet::sAtoms[AtomSet::Count];
+
+void AtomSet::setup(xcb_ewmh_connection_t* ewmhConn)
+{
+    const xcb_atom_t atoms[] = {
+        ewmhConn->_NET_WM_WINDOW_TYPE_DESKTOP,
+        ewmhConn->_NET_WM_WINDOW_TYPE_DOCK,
+        ewmhConn->_NET_WM_WINDOW_TYPE_TOOLBAR,
+        ewmhConn->_NET_WM_WINDOW_TYPE_MENU,
+        ewmhConn->_NET_WM_WINDOW_TYPE_UTILITY,
+        ewmhConn->_NET_WM_WINDOW_TYPE_SPLASH,
+        ewmhConn->_NET_WM_WINDOW_TYPE_DIALOG,
+        ewmhConn->_NET_WM_WINDOW_TYPE_DROPDOWN_MENU,
+        ewmhConn->_NET_WM_WINDOW_TYPE_POPUP_MENU,
+        ewmhConn->_NET_WM_WINDOW_TYPE_TOOLTIP,
+        ewmhConn->_NET_WM_WINDOW_TYPE_NOTIFICATION,
+        ewmhConn->_NET_WM_WINDOW_TYPE_COMBO,
+        ewmhConn->_NET_WM_WINDOW_TYPE_DND,
+        ewmhConn->_NET_WM_WINDOW_TYPE_NORMAL,
+
+        ewmhConn->_NET_WM_STATE_MODAL,
+        ewmhConn->_NET_WM_STATE_STICKY,
+        ewmhConn->_NET_WM_STATE_MAXIMIZED_VERT,
+        ewmhConn->_NET_WM_STATE_MAXIMIZED_HORZ,
+        ewmhConn->_NET_WM_STATE_SHADED,
+        ewmhConn->_NET_WM_STATE_SKIP_TASKBAR,
+        ewmhConn->_NET_WM_STATE_SKIP_PAGER,
+        ewmhConn->_NET_WM_STATE_HIDDEN,
+        ewmhConn->_NET_WM_STATE_FULLSCREEN,
+        ewmhConn->_NET_WM_STATE_ABOVE,
+        ewmhConn->_NET_WM_STATE_BELOW,
+        ewmhConn->_NET_WM_STATE_DEMANDS_ATTENTION,
+
+        Atoms::WM_TAKE_FOCUS,
+        Atoms::WM_DELETE_WINDOW
+    };
+    static_assert(sizeof(atoms) / sizeof(atoms[0]) == Count, "AtomSet::setup is out of sync with AtomSet::Atom");
+
+    sIndices.clear();
+    for (int i = 0; i < Count; ++i) {
+        sAtoms[i] = atoms[i];
+        if (atoms[i] != XCB_ATOM_NONE)
+            sIndices[atoms[i]] = i;
+    }
+}
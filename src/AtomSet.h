@@ -0,0 +1,97 @@
+#ifndef ATOMSET_H
+#define ATOMSET_H
+
+#include <rct/Hash.h>
+#include <rct/List.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_ewmh.h>
+#include <stdint.h>
+
+// The atoms we classify windows by are mapped to small indices once at
+// startup, which lets a client keep its window types, state and protocols in
+// a single word instead of a set of atoms.
+class AtomSet
+{
+public:
+    enum Atom {
+        TypeDesktop,
+        TypeDock,
+        TypeToolbar,
+        TypeMenu,
+        TypeUtility,
+        TypeSplash,
+        TypeDialog,
+        TypeDropdownMenu,
+        TypePopupMenu,
+        TypeTooltip,
+        TypeNotification,
+        TypeCombo,
+        TypeDnd,
+        TypeNormal,
+
+        StateModal,
+        StateSticky,
+        StateMaximizedVert,
+        StateMaximizedHorz,
+        StateShaded,
+        StateSkipTaskbar,
+        StateSkipPager,
+        StateHidden,
+        StateFullscreen,
+        StateAbove,
+        StateBelow,
+        StateDemandsAttention,
+
+        ProtocolTakeFocus,
+        ProtocolDeleteWindow,
+
+        Count
+    };
+    static_assert(Count <= 32, "AtomSet needs a wider word");
+
+    // needs the ewmh atoms and Atoms::setup()
+    static void setup(xcb_ewmh_connection_t* ewmhConn);
+
+    // -1 for atoms we don't classify by
+    static int index(xcb_atom_t atom)
+    {
+        const auto it = sIndices.find(atom);
+        return it == sIndices.end() ? -1 : it->second;
+    }
+    static xcb_atom_t atom(Atom index) { return sAtoms[index]; }
+
+    AtomSet()
+        : mBits(0)
+    {}
+
+    void clear() { mBits = 0; }
+    bool isEmpty() const { return !mBits; }
+    List<xcb_atom_t> atoms() const
+    {
+        List<xcb_atom_t> ret;
+        for (int i = 0; i < Count; ++i) {
+            if (mBits & (1u << i))
+                ret.append(sAtoms[i]);
+        }
+        return ret;
+    }
+    bool contains(Atom index) const { return mBits & (1u << index); }
+    void insert(Atom index) { mBits |= (1u << index); }
+    // returns false if the atom isn't one we classify by
+    bool insert(xcb_atom_t atom)
+    {
+        const int idx = index(atom);
+        if (idx == -1)
+            return false;
+        mBits |= (1u << idx);
+        return true;
+    }
+
+private:
+    uint32_t mBits;
+
+    static Hash<xcb_atom_t, int> sIndices;
+    static xcb_atom_t sAtoms[Count];
+};
+
+#endif
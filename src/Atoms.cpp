@@ -1,6 +1,8 @@
 #include "Atoms.h"
 #include "WindowManager.h"
+#include <rct/Hash.h>
 #include <rct/Log.h>
+#include <rct/Set.h>
 #include <vector>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +13,17 @@ struct Atom
     xcb_atom_t& atom;
 };
 
+// every atom we've interned or seen the name of
+static Hash<xcb_atom_t, std::string> sNames;
+static Set<xcb_atom_t> sPending;
+
+static inline void insert(const char* name, xcb_atom_t atom)
+{
+    if (atom == XCB_ATOM_NONE)
+        return;
+    sNames[atom] = name;
+}
+
 template<int Count>
 static void setupAtoms(Atom (&atoms)[Count], xcb_connection_t* conn)
 {
@@ -21,8 +34,9 @@ static void setupAtoms(Atom (&atoms)[Count], xcb_connection_t* conn)
     }
     xcb_generic_error_t* err;
     for (int i = 0; i < Count; ++i) {
-        if (xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(conn, cookies[i], &err)) {
+        if (xcb_intern_atom_reply_t* reply = ROUND_TRIP(xcb_intern_atom_reply(conn, cookies[i], &err))) {
             atoms[i].atom = reply->atom;
+            insert(atoms[i].name, reply->atom);
             free(reply);
         } else {
             atoms[i].atom = 0;
@@ -81,29 +95,119 @@ bool setup(xcb_connection_t* conn)
         { "_XEMBED_INFO", _XEMBED_INFO },
         { "_XROOTPMAP_ID", _XROOTPMAP_ID }
     };
+    sNames.clear();
+    sPending.clear();
+
+    // the predefined ones never change
+    insert("PRIMARY", XCB_ATOM_PRIMARY);
+    insert("SECONDARY", XCB_ATOM_SECONDARY);
+    insert("ATOM", XCB_ATOM_ATOM);
+    insert("CARDINAL", XCB_ATOM_CARDINAL);
+    insert("PIXMAP", XCB_ATOM_PIXMAP);
+    insert("STRING", XCB_ATOM_STRING);
+    insert("WINDOW", XCB_ATOM_WINDOW);
+    insert("WM_COMMAND", XCB_ATOM_WM_COMMAND);
+    insert("WM_HINTS", XCB_ATOM_WM_HINTS);
+    insert("WM_CLIENT_MACHINE", XCB_ATOM_WM_CLIENT_MACHINE);
+    insert("WM_ICON_NAME", XCB_ATOM_WM_ICON_NAME);
+    insert("WM_ICON_SIZE", XCB_ATOM_WM_ICON_SIZE);
+    insert("WM_NAME", XCB_ATOM_WM_NAME);
+    insert("WM_NORMAL_HINTS", XCB_ATOM_WM_NORMAL_HINTS);
+    insert("WM_SIZE_HINTS", XCB_ATOM_WM_SIZE_HINTS);
+    insert("WM_CLASS", XCB_ATOM_WM_CLASS);
+    insert("WM_TRANSIENT_FOR", XCB_ATOM_WM_TRANSIENT_FOR);
+
     setupAtoms(atoms, conn);
     return true;
 }
 
+void setup(xcb_ewmh_connection_t* ewmhConn)
+{
+#define EWMH_ATOM(atom) insert(#atom, ewmhConn->atom)
+    EWMH_ATOM(_NET_SUPPORTED);
+    EWMH_ATOM(_NET_CLIENT_LIST);
+    EWMH_ATOM(_NET_CLIENT_LIST_STACKING);
+    EWMH_ATOM(_NET_NUMBER_OF_DESKTOPS);
+    EWMH_ATOM(_NET_CURRENT_DESKTOP);
+    EWMH_ATOM(_NET_ACTIVE_WINDOW);
+    EWMH_ATOM(_NET_SUPPORTING_WM_CHECK);
+    EWMH_ATOM(_NET_CLOSE_WINDOW);
+    EWMH_ATOM(_NET_MOVERESIZE_WINDOW);
+    EWMH_ATOM(_NET_WM_MOVERESIZE);
+    EWMH_ATOM(_NET_WM_NAME);
+    EWMH_ATOM(_NET_WM_VISIBLE_NAME);
+    EWMH_ATOM(_NET_WM_ICON_NAME);
+    EWMH_ATOM(_NET_WM_DESKTOP);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE);
+    EWMH_ATOM(_NET_WM_STATE);
+    EWMH_ATOM(_NET_WM_ALLOWED_ACTIONS);
+    EWMH_ATOM(_NET_WM_STRUT);
+    EWMH_ATOM(_NET_WM_STRUT_PARTIAL);
+    EWMH_ATOM(_NET_WM_ICON_GEOMETRY);
+    EWMH_ATOM(_NET_WM_ICON);
+    EWMH_ATOM(_NET_WM_PID);
+    EWMH_ATOM(_NET_WM_USER_TIME);
+    EWMH_ATOM(_NET_WM_USER_TIME_WINDOW);
+    EWMH_ATOM(_NET_FRAME_EXTENTS);
+    EWMH_ATOM(_NET_WM_PING);
+    EWMH_ATOM(_NET_WM_SYNC_REQUEST);
+    EWMH_ATOM(_NET_WM_SYNC_REQUEST_COUNTER);
+    EWMH_ATOM(_NET_WM_FULLSCREEN_MONITORS);
+    EWMH_ATOM(_NET_WM_FULL_PLACEMENT);
+
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_DESKTOP);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_DOCK);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_TOOLBAR);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_MENU);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_UTILITY);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_SPLASH);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_DIALOG);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_DROPDOWN_MENU);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_POPUP_MENU);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_TOOLTIP);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_NOTIFICATION);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_COMBO);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_DND);
+    EWMH_ATOM(_NET_WM_WINDOW_TYPE_NORMAL);
+
+    EWMH_ATOM(_NET_WM_STATE_MODAL);
+    EWMH_ATOM(_NET_WM_STATE_STICKY);
+    EWMH_ATOM(_NET_WM_STATE_MAXIMIZED_VERT);
+    EWMH_ATOM(_NET_WM_STATE_MAXIMIZED_HORZ);
+    EWMH_ATOM(_NET_WM_STATE_SHADED);
+    EWMH_ATOM(_NET_WM_STATE_SKIP_TASKBAR);
+    EWMH_ATOM(_NET_WM_STATE_SKIP_PAGER);
+    EWMH_ATOM(_NET_WM_STATE_HIDDEN);
+    EWMH_ATOM(_NET_WM_STATE_FULLSCREEN);
+    EWMH_ATOM(_NET_WM_STATE_ABOVE);
+    EWMH_ATOM(_NET_WM_STATE_BELOW);
+    EWMH_ATOM(_NET_WM_STATE_DEMANDS_ATTENTION);
+#undef EWMH_ATOM
+}
+
 std::string name(xcb_atom_t atom)
 {
-    xcb_connection_t* conn = WindowManager::instance()->connection();
-    xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(conn, atom);
-    xcb_generic_error_t* err;
-    xcb_get_atom_name_reply_t* reply = xcb_get_atom_name_reply(conn, cookie, &err);
-    if (err) {
-        LOG_ERROR(err, "Couldn't get atom name");
-        free(err);
-        return std::string();
-    }
+    const auto it = sNames.find(atom);
+    if (it != sNames.end())
+        return it->second;
 
-    std::string name;
-    if (reply) {
-        const int len = xcb_get_atom_name_name_length(reply);
-        name = std::string(xcb_get_atom_name_name(reply), len);
-        free(reply);
+    WindowManager* wm = WindowManager::instance();
+    if (!sPending.contains(atom) && wm && wm->connection()) {
+        sPending.insert(atom);
+        xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(wm->connection(), atom);
+        wm->replies().wait<xcb_get_atom_name_reply_t>(cookie, [atom](xcb_get_atom_name_reply_t* reply, xcb_generic_error_t* err) {
+                sPending.remove(atom);
+                if (err) {
+                    LOG_ERROR(err, "Couldn't get atom name");
+                    return;
+                }
+                if (reply) {
+                    const std::string name(xcb_get_atom_name_name(reply), xcb_get_atom_name_name_length(reply));
+                    sNames[atom] = name;
+                }
+            });
     }
-    return name;
+    return "atom:" + std::to_string(atom);
 }
 
 } // namespace Atoms
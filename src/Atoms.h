@@ -3,6 +3,7 @@
 
 #include <string>
 #include <xcb/xcb_atom.h>
+#include <xcb/xcb_ewmh.h>
 
 namespace Atoms
 {
@@ -28,7 +29,14 @@ extern xcb_atom_t _XEMBED_INFO;
 extern xcb_atom_t _XROOTPMAP_ID;
 
 bool setup(xcb_connection_t* conn);
-std::string name(xcb_atom_t atom); // not efficient, call this for debugging only
+// adds the names of the ewmh atoms we use to the table
+void setup(xcb_ewmh_connection_t* ewmhConn);
+
+// Never blocks. Names that aren't in the table yet are asked for and a
+// placeholder is returned until the reply comes in. That request goes out
+// the first time an unknown atom is passed in, even if it's only for a log
+// line below the log level.
+std::string name(xcb_atom_t atom);
 };
 
 #endif
@@ -8,11 +8,20 @@
 #include <signal.h>
 
 Hash<xcb_window_t, Client*> Client::sClients;
+List<xcb_window_t> Client::sDirtyClients;
+List<Client*> Client::sDoomed;
+bool Client::sReaping = false;
+static Pool<Client> sPool;
 
 Client::Client(xcb_window_t win)
     : mWindow(win), mFrame(XCB_NONE), mNoFocus(false), mOwned(false),
-      mMovable(false), mWorkspace(0), mGraphics(0), mPid(0), mScreenNumber(0)
+      mMovable(false), mHideMode(HideDefault), mParked(false), mLayoutPending(false), mWorkspace(0), mGraphics(0), mTransientFor(XCB_NONE),
+      mWindowType(AtomSet::atom(AtomSet::TypeNormal)), mGroup(0),
+      mPid(0), mScreenNumber(0), mLoaded(0), mFetching(0), mTakeFocusPending(false)
 {
+    memset(&mNormalHints, '\0', sizeof(mNormalHints));
+    memset(&mWmHints, '\0', sizeof(mWmHints));
+    memset(&mStrut, '\0', sizeof(mStrut));
     warning() << "making client";
 }
 
@@ -20,6 +29,8 @@ Client::~Client()
 {
     if (mWorkspace)
         mWorkspace->onClientDestroyed(this);
+    if (WindowManager::instance()->focusedClient() == this)
+        WindowManager::instance()->setFocusedClient(0);
     WindowManager::instance()->js().onClientDestroyed(this);
     assert(mJSValue.isInvalid() || mJSValue.isCustom());
     if (!mJSValue.isInvalid()) {
@@ -38,12 +49,71 @@ Client::~Client()
             xcb_destroy_window(conn, mWindow);
         }
         sClients.erase(mWindow);
+        WindowManager::instance()->windows().remove(mWindow);
     }
+    WindowManager::instance()->windows().remove(mFrame);
     xcb_destroy_window(conn, mFrame);
     if (mGroup)
         mGroup->onClientDestroyed(this);
 }
 
+void *Client::operator new(size_t size)
+{
+    assert(size == sizeof(Client));
+    (void)size;
+    return sPool.allocate();
+}
+
+void Client::operator delete(void *ptr)
+{
+    sPool.release(ptr);
+}
+
+const PoolStats &Client::poolStats()
+{
+    return sPool.stats();
+}
+
+void Client::destroyLater()
+{
+    // reap() normally runs at the end of the event batch, this catches
+    // anything destroyed outside of one
+    if (sDoomed.isEmpty())
+        EventLoop::eventLoop()->callLater([]() { Client::reap(); });
+    // only the delete waits, nothing gets to focus or configure us in the
+    // meantime
+    WindowManager *wm = WindowManager::instance();
+    if (mWorkspace)
+        mWorkspace->onClientDoomed(this);
+    if (wm->focusedClient() == this)
+        wm->setFocusedClient(0);
+    WindowRegistry &windows = wm->windows();
+    windows.remove(mWindow);
+    windows.remove(mFrame);
+    sClients.erase(mWindow);
+    sDoomed.append(this);
+}
+
+void Client::reap()
+{
+    if (sDoomed.isEmpty())
+        return;
+    // workspaces that lose their focused client pick a new one once all of
+    // the batch is gone, not once per client
+    List<Workspace*> workspaces;
+    sReaping = true;
+    for (Client *client : sDoomed) {
+        if (client->mWorkspace && !workspaces.contains(client->mWorkspace))
+            workspaces.append(client->mWorkspace);
+        delete client;
+    }
+    sDoomed.clear();
+    sReaping = false;
+    for (Workspace *workspace : workspaces)
+        workspace->settleFocus();
+    WindowManager::instance()->scheduleFlush();
+}
+
 void Client::init()
 {
     WindowManager *wm = WindowManager::instance();
@@ -53,14 +123,30 @@ void Client::init()
 }
 
 void Client::complete()
+{
+    place();
+    createFrame();
+    {
+        xcb_connection_t* conn = WindowManager::instance()->connection();
+        const xcb_window_t rootWindow = root();
+        ServerGrabScope grabScope(conn);
+        const uint32_t noValue[] = { 0 };
+        xcb_change_window_attributes(conn, rootWindow, XCB_CW_EVENT_MASK, noValue);
+        reparent();
+        const uint32_t rootEvent[] = { Types::RootEventMask };
+        xcb_change_window_attributes(conn, rootWindow, XCB_CW_EVENT_MASK, rootEvent);
+    }
+    finish();
+}
+
+void Client::place()
 {
     WindowManager *wm = WindowManager::instance();
-    xcb_connection_t* conn = wm->connection();
-    xcb_ewmh_connection_t* ewmhConn = wm->ewmhConnection();
-    if (mEwmhState.contains(ewmhConn->_NET_WM_STATE_STICKY)) {
+    if (mEwmhState.contains(AtomSet::StateSticky)) {
         // don't put in layout
 #warning support strut windows in layouts (reserved space)
 #warning support partial struts
+        load(LazyStrut);
         Rect rect = wm->rect(mScreenNumber);
         if (mStrut.left) {
             if (mRect.width != static_cast<int>(mStrut.left))
@@ -87,17 +173,22 @@ void Client::complete()
         }
         wm->setRect(rect, mScreenNumber);
         warning() << "fixed at" << mRect;
-    } else {
-        if (shouldLayout()) {
-            wm->js().onLayout(this);
-            warning() << "laid out at" << mRect;
-        }
+    } else if (mWorkspace && shouldLayout()) {
+        // for a hidden workspace this waits until it's shown
+        mWorkspace->layout(this);
     }
+}
+
+void Client::createFrame()
+{
+    WindowManager *wm = WindowManager::instance();
+    xcb_connection_t* conn = wm->connection();
 #warning do startup-notification stuff here
     if (!mOwned)
         xcb_change_save_set(conn, XCB_SET_MODE_INSERT, mWindow);
     xcb_screen_t* scr = screen();
     mFrame = xcb_generate_id(conn);
+    wm->windows().insert(mFrame, WindowRegistry::FrameWindow, this, mScreenNumber);
     const uint32_t values[] = {
         scr->black_pixel,
         XCB_GRAVITY_NORTH_WEST,
@@ -118,20 +209,24 @@ void Client::complete()
                       XCB_COPY_FROM_PARENT, XCB_COPY_FROM_PARENT,
                       XCB_CW_BORDER_PIXEL | XCB_CW_BIT_GRAVITY | XCB_CW_WIN_GRAVITY
                       | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK, values);
-    {
-        ServerGrabScope grabScope(conn);
-        const uint32_t noValue[] = { 0 };
-        xcb_change_window_attributes(conn, scr->root, XCB_CW_EVENT_MASK, noValue);
-        xcb_reparent_window(conn, mWindow, mFrame, 0, 0);
-        const uint32_t rootEvent[] = { Types::RootEventMask };
-        xcb_change_window_attributes(conn, scr->root, XCB_CW_EVENT_MASK, rootEvent);
-        xcb_grab_button(conn, false, mWindow, XCB_EVENT_MASK_BUTTON_PRESS,
-                        XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, scr->root,
-                        XCB_NONE, 1, XCB_BUTTON_MASK_ANY);
-        const uint32_t windowEvent[] = { Types::ClientInputMask };
-        xcb_change_window_attributes(conn, mWindow, XCB_CW_EVENT_MASK, windowEvent);
-    }
+}
 
+// the caller grabs the server and keeps the root from reporting the reparent
+void Client::reparent()
+{
+    xcb_connection_t* conn = WindowManager::instance()->connection();
+    xcb_reparent_window(conn, mWindow, mFrame, 0, 0);
+    xcb_grab_button(conn, false, mWindow, XCB_EVENT_MASK_BUTTON_PRESS,
+                    XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, root(),
+                    XCB_NONE, 1, XCB_BUTTON_MASK_ANY);
+    const uint32_t windowEvent[] = { Types::ClientInputMask };
+    xcb_change_window_attributes(conn, mWindow, XCB_CW_EVENT_MASK, windowEvent);
+}
+
+void Client::finish()
+{
+    WindowManager *wm = WindowManager::instance();
+    xcb_connection_t* conn = wm->connection();
     {
         uint16_t windowMask = XCB_CONFIG_WINDOW_WIDTH|XCB_CONFIG_WINDOW_HEIGHT|XCB_CONFIG_WINDOW_BORDER_WIDTH;
         uint32_t windowValues[3];
@@ -146,7 +241,13 @@ void Client::complete()
     const uint32_t stateMode[] = { XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE };
     xcb_change_property(conn, XCB_PROP_MODE_REPLACE, mWindow, Atoms::WM_STATE, Atoms::WM_STATE, 32, 2, stateMode);
 
-    map();
+    // adopted clients can land on a workspace that isn't shown, they were
+    // added to it before they had a frame to hide
+    const bool shown = !mWorkspace || wm->activeWorkspace(mScreenNumber) == mWorkspace;
+    if (!shown)
+        hide();
+    if (shown || mParked)
+        map();
     raise();
     warning() << "created and mapped parent client for frame" << mFrame << "with window" << mWindow;
 }
@@ -164,51 +265,223 @@ bool Client::updateWorkspace(Workspace *workspace)
         return true;
     mWorkspace->removeClient(this);
     mWorkspace = workspace;
-    if (shouldLayout()) {
-        WindowManager::instance()->js().onLayout(this);
-    }
+    if (shouldLayout())
+        mWorkspace->layout(this);
 
     return true;
 }
 
 void Client::updateState(xcb_ewmh_connection_t* ewmhConn)
 {
+    if (mOwned) {
+        // create() filled in what we told the server, there's nothing to ask
+        updateLeader(0);
+        mLoaded = AllLazy;
+        return;
+    }
+
+    StateRequest request;
+    requestState(&request);
+    readState(request);
+
+    // docks and sticky windows are placed by their struts
+    if (mWindowTypes.contains(AtomSet::TypeDock) || mEwmhState.contains(AtomSet::StateSticky)) {
+        load(LazyStrut);
+    }
+}
+
+void Client::requestState(StateRequest *request, unsigned lazy) const
+{
+    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
+    request->geometry = xcb_get_geometry_unchecked(ewmhConn->connection, mWindow);
+    // only what's needed to classify and place the window, see LazyProperty.
+    // the order matters, the transient and window type decoders depend on the group
+    int count = 0;
+    request->atoms[count++] = XCB_ATOM_WM_NORMAL_HINTS;
+    request->atoms[count++] = Atoms::WM_CLIENT_LEADER;
+    request->atoms[count++] = XCB_ATOM_WM_TRANSIENT_FOR;
+    request->atoms[count++] = XCB_ATOM_WM_HINTS;
+    request->atoms[count++] = XCB_ATOM_WM_CLASS;
+    request->atoms[count++] = ewmhConn->_NET_WM_STATE;
+    request->atoms[count++] = ewmhConn->_NET_WM_WINDOW_TYPE;
+    count += lazyAtoms(lazy & ~mLoaded, request->atoms + count);
+    assert(count <= StateRequest::MaxAtoms);
+    request->count = count;
+    for (int i = 0; i < count; ++i) {
+        const bool ok = requestProperty(request->atoms[i], &request->cookies[i]);
+        assert(ok);
+        (void)ok;
+    }
+}
+
+void Client::readState(const StateRequest &request)
+{
+    xcb_connection_t* conn = WindowManager::instance()->connection();
+    AutoPointer<xcb_get_geometry_reply_t> geom(ROUND_TRIP(xcb_get_geometry_reply(conn, request.geometry, 0)));
+    updateSize(geom);
+    for (int i = 0; i < request.count; ++i) {
+        AutoPointer<xcb_get_property_reply_t> reply(ROUND_TRIP(xcb_get_property_reply(conn, request.cookies[i], 0)));
+        updateProperty(request.atoms[i], reply);
+    }
+}
+
+unsigned Client::lazyProperty(xcb_atom_t atom)
+{
+    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
+    if (atom == XCB_ATOM_WM_NAME)
+        return LazyName;
+    if (atom == ewmhConn->_NET_WM_PID)
+        return LazyPid;
+    if (atom == Atoms::WM_PROTOCOLS)
+        return LazyProtocols;
+    if (atom == ewmhConn->_NET_WM_STRUT || atom == ewmhConn->_NET_WM_STRUT_PARTIAL)
+        return LazyStrut;
+    return 0;
+}
+
+int Client::lazyAtoms(unsigned props, xcb_atom_t* atoms)
+{
+    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
+    int count = 0;
+    if (props & LazyName)
+        atoms[count++] = XCB_ATOM_WM_NAME;
+    if (props & LazyPid)
+        atoms[count++] = ewmhConn->_NET_WM_PID;
+    if (props & LazyProtocols)
+        atoms[count++] = Atoms::WM_PROTOCOLS;
+    if (props & LazyStrut) {
+        // the partial strut supersedes the plain one so it has to come last
+        atoms[count++] = ewmhConn->_NET_WM_STRUT;
+        atoms[count++] = ewmhConn->_NET_WM_STRUT_PARTIAL;
+    }
+    return count;
+}
+
+void Client::load(unsigned props)
+{
+    props &= ~mLoaded;
+    if (!props)
+        return;
+    xcb_connection_t* conn = WindowManager::instance()->connection();
+    xcb_atom_t atoms[5];
+    const int count = lazyAtoms(props, atoms);
+    xcb_get_property_cookie_t cookies[5];
+    for (int i = 0; i < count; ++i)
+        requestProperty(atoms[i], &cookies[i]);
+    for (int i = 0; i < count; ++i) {
+        AutoPointer<xcb_get_property_reply_t> reply(ROUND_TRIP(xcb_get_property_reply(conn, cookies[i], 0)));
+        updateProperty(atoms[i], reply);
+    }
+}
+
+void Client::prefetch(unsigned props)
+{
+    props &= ~(mLoaded | mFetching);
+    if (!props)
+        return;
+    mFetching |= props;
+    Replies& replies = WindowManager::instance()->replies();
+    const xcb_window_t window = mWindow;
+    xcb_atom_t atoms[5];
+    const int count = lazyAtoms(props, atoms);
+    for (int i = 0; i < count; ++i) {
+        const xcb_atom_t atom = atoms[i];
+        xcb_get_property_cookie_t cookie;
+        requestProperty(atom, &cookie);
+        replies.wait<xcb_get_property_reply_t>(cookie, [window, atom](xcb_get_property_reply_t* reply, xcb_generic_error_t*) {
+                if (Client *client = Client::client(window))
+                    client->updateProperty(atom, reply);
+            });
+    }
+}
+
+bool Client::requestProperty(xcb_atom_t atom, xcb_get_property_cookie_t* cookie) const
+{
+    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
     xcb_connection_t* conn = ewmhConn->connection;
-    xcb_get_geometry_cookie_t geomCookie;
-    if (!mOwned)
-        geomCookie = xcb_get_geometry_unchecked(conn, mWindow);
-    const xcb_get_property_cookie_t normalHintsCookie = xcb_icccm_get_wm_normal_hints(conn, mWindow);
-    const xcb_get_property_cookie_t leaderCookie = xcb_get_property(conn, 0, mWindow, Atoms::WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 1);
-    const xcb_get_property_cookie_t transientCookie = xcb_icccm_get_wm_transient_for(conn, mWindow);
-    const xcb_get_property_cookie_t hintsCookie = xcb_icccm_get_wm_hints(conn, mWindow);
-    const xcb_get_property_cookie_t classCookie = xcb_icccm_get_wm_class(conn, mWindow);
-    const xcb_get_property_cookie_t nameCookie = xcb_icccm_get_wm_name(conn, mWindow);
-    const xcb_get_property_cookie_t protocolsCookie = xcb_icccm_get_wm_protocols(conn, mWindow, Atoms::WM_PROTOCOLS);
-    const xcb_get_property_cookie_t strutCookie = xcb_ewmh_get_wm_strut(ewmhConn, mWindow);
-    const xcb_get_property_cookie_t partialStrutCookie = xcb_ewmh_get_wm_strut_partial(ewmhConn, mWindow);
-    const xcb_get_property_cookie_t stateCookie = xcb_ewmh_get_wm_state(ewmhConn, mWindow);
-    const xcb_get_property_cookie_t typeCookie = xcb_ewmh_get_wm_window_type(ewmhConn, mWindow);
-    const xcb_get_property_cookie_t pidCookie = xcb_ewmh_get_wm_pid(ewmhConn, mWindow);
+    if (atom == XCB_ATOM_WM_NORMAL_HINTS) {
+        *cookie = xcb_icccm_get_wm_normal_hints(conn, mWindow);
+    } else if (atom == XCB_ATOM_WM_TRANSIENT_FOR) {
+        *cookie = xcb_icccm_get_wm_transient_for(conn, mWindow);
+    } else if (atom == Atoms::WM_CLIENT_LEADER) {
+        *cookie = xcb_get_property(conn, 0, mWindow, Atoms::WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 1);
+    } else if (atom == XCB_ATOM_WM_HINTS) {
+        *cookie = xcb_icccm_get_wm_hints(conn, mWindow);
+    } else if (atom == XCB_ATOM_WM_CLASS) {
+        *cookie = xcb_icccm_get_wm_class(conn, mWindow);
+    } else if (atom == XCB_ATOM_WM_NAME) {
+        *cookie = xcb_icccm_get_wm_name(conn, mWindow);
+    } else if (atom == Atoms::WM_PROTOCOLS) {
+        *cookie = xcb_icccm_get_wm_protocols(conn, mWindow, Atoms::WM_PROTOCOLS);
+    } else if (atom == ewmhConn->_NET_WM_STRUT) {
+        *cookie = xcb_ewmh_get_wm_strut(ewmhConn, mWindow);
+    } else if (atom == ewmhConn->_NET_WM_STRUT_PARTIAL) {
+        *cookie = xcb_ewmh_get_wm_strut_partial(ewmhConn, mWindow);
+    } else if (atom == ewmhConn->_NET_WM_STATE) {
+        *cookie = xcb_ewmh_get_wm_state(ewmhConn, mWindow);
+    } else if (atom == ewmhConn->_NET_WM_WINDOW_TYPE) {
+        *cookie = xcb_ewmh_get_wm_window_type(ewmhConn, mWindow);
+    } else if (atom == ewmhConn->_NET_WM_PID) {
+        *cookie = xcb_ewmh_get_wm_pid(ewmhConn, mWindow);
+    } else {
+        return false;
+    }
+    return true;
+}
 
-    if (!mOwned)
-        updateSize(conn, geomCookie);
-    updateNormalHints(conn, normalHintsCookie);
-    updateLeader(conn, leaderCookie);
-    updateTransient(conn, transientCookie);
-    updateHints(conn, hintsCookie);
-    updateClass(conn, classCookie);
-    updateName(conn, nameCookie);
-    updateProtocols(conn, protocolsCookie);
-    updateStrut(ewmhConn, strutCookie);
-    updatePartialStrut(ewmhConn, partialStrutCookie);
-    updateEwmhState(ewmhConn, stateCookie);
-    updateWindowTypes(ewmhConn, typeCookie);
-    updatePid(ewmhConn, pidCookie);
-}
-
-void Client::updateLeader(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
-{
-    AutoPointer<xcb_get_property_reply_t> leader(xcb_get_property_reply(conn, cookie, 0));
+void Client::updateProperty(xcb_atom_t atom, xcb_get_property_reply_t* reply)
+{
+    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
+    if (atom == XCB_ATOM_WM_NORMAL_HINTS) {
+        updateNormalHints(reply);
+    } else if (atom == XCB_ATOM_WM_TRANSIENT_FOR) {
+        updateTransient(reply);
+    } else if (atom == Atoms::WM_CLIENT_LEADER) {
+        updateLeader(reply);
+    } else if (atom == XCB_ATOM_WM_HINTS) {
+        updateHints(reply);
+    } else if (atom == XCB_ATOM_WM_CLASS) {
+        updateClass(reply);
+    } else if (atom == XCB_ATOM_WM_NAME) {
+        updateName(reply);
+    } else if (atom == Atoms::WM_PROTOCOLS) {
+        updateProtocols(reply);
+    } else if (atom == ewmhConn->_NET_WM_STRUT) {
+        updateStrut(reply);
+    } else if (atom == ewmhConn->_NET_WM_STRUT_PARTIAL) {
+        updatePartialStrut(reply);
+    } else if (atom == ewmhConn->_NET_WM_STATE) {
+        updateEwmhState(reply);
+    } else if (atom == ewmhConn->_NET_WM_WINDOW_TYPE) {
+        updateWindowTypes(reply);
+    } else if (atom == ewmhConn->_NET_WM_PID) {
+        updatePid(reply);
+    }
+
+    // a strut is only complete once the partial one is in
+    const unsigned prop = atom == ewmhConn->_NET_WM_STRUT ? 0 : lazyProperty(atom);
+    if (prop) {
+        mLoaded |= prop;
+        mFetching &= ~prop;
+        if (prop == LazyProtocols && mTakeFocusPending)
+            sendTakeFocus();
+    }
+}
+
+// the xcb-util *_from_reply helpers for atom lists and strings take ownership
+// of the reply, so those are decoded by hand
+static inline const xcb_atom_t* atomsFromReply(xcb_get_property_reply_t* reply, int* count)
+{
+    if (!reply || reply->type != XCB_ATOM_ATOM || reply->format != 32) {
+        *count = 0;
+        return 0;
+    }
+    *count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+    return static_cast<const xcb_atom_t*>(xcb_get_property_value(reply));
+}
+
+void Client::updateLeader(xcb_get_property_reply_t* leader)
+{
     if (!leader || leader->type != XCB_ATOM_WINDOW || leader->format != 32 || !leader->length) {
         mGroup = ClientGroup::clientGroup(mWindow);
         mGroup->add(this);
@@ -220,15 +493,16 @@ void Client::updateLeader(xcb_connection_t* conn, xcb_get_property_cookie_t cook
     mGroup->add(this);
 }
 
-void Client::updateSize(xcb_connection_t* conn, xcb_get_geometry_cookie_t cookie)
+void Client::updateSize(xcb_get_geometry_reply_t* geom)
 {
-    AutoPointer<xcb_get_geometry_reply_t> geom(xcb_get_geometry_reply(conn, cookie, 0));
+    if (!geom)
+        return;
     mRect = Rect(geom->x, geom->y, geom->width, geom->height);
 }
 
-void Client::updateNormalHints(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateNormalHints(xcb_get_property_reply_t* reply)
 {
-    if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie, &mNormalHints, 0)) {
+    if (reply && xcb_icccm_get_wm_size_hints_from_reply(&mNormalHints, reply)) {
         // overwrite the response from xcb_get_geometry_unchecked
         enum { SIZE = (XCB_ICCCM_SIZE_HINT_US_SIZE|XCB_ICCCM_SIZE_HINT_P_SIZE) };
         if ((mNormalHints.flags & SIZE) == SIZE) {
@@ -245,9 +519,9 @@ void Client::updateNormalHints(xcb_connection_t* conn, xcb_get_property_cookie_t
     }
 }
 
-void Client::updateTransient(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateTransient(xcb_get_property_reply_t* reply)
 {
-    if (!xcb_icccm_get_wm_transient_for_reply(conn, cookie, &mTransientFor, 0)) {
+    if (!reply || !xcb_icccm_get_wm_transient_for_from_reply(&mTransientFor, reply)) {
         mTransientFor = XCB_NONE;
     } else {
         if (mTransientFor == XCB_NONE || mTransientFor == root()) {
@@ -276,9 +550,9 @@ void Client::updateTransient(xcb_connection_t* conn, xcb_get_property_cookie_t c
     }
 }
 
-void Client::updateHints(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateHints(xcb_get_property_reply_t* reply)
 {
-    if (xcb_icccm_get_wm_hints_reply(conn, cookie, &mWmHints, 0)) {
+    if (reply && xcb_icccm_get_wm_hints_from_reply(&mWmHints, reply)) {
         if (mWmHints.flags & XCB_ICCCM_WM_HINT_INPUT) {
             mNoFocus = !mWmHints.input;
         }
@@ -287,51 +561,47 @@ void Client::updateHints(xcb_connection_t* conn, xcb_get_property_cookie_t cooki
     }
 }
 
-void Client::updateClass(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateClass(xcb_get_property_reply_t* reply)
 {
-    xcb_icccm_get_wm_class_reply_t prop;
-    if (xcb_icccm_get_wm_class_reply(conn, cookie, &prop, 0)) {
-        mClass.instanceName = prop.instance_name;
-        mClass.className = prop.class_name;
-        xcb_icccm_get_wm_class_reply_wipe(&prop);
-    } else {
-        mClass.instanceName.clear();
-        mClass.className.clear();
+    mClass.instanceName.clear();
+    mClass.className.clear();
+    if (!reply || reply->type != XCB_ATOM_STRING || reply->format != 8)
+        return;
+    // "instance\0class\0"
+    const char* data = static_cast<const char*>(xcb_get_property_value(reply));
+    const int length = xcb_get_property_value_length(reply);
+    const int instanceLength = strnlen(data, length);
+    mClass.instanceName = String(data, instanceLength);
+    if (instanceLength + 1 < length) {
+        const char* clazz = data + instanceLength + 1;
+        mClass.className = String(clazz, strnlen(clazz, length - instanceLength - 1));
     }
 }
 
-void Client::updateName(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateName(xcb_get_property_reply_t* reply)
 {
-    xcb_icccm_get_text_property_reply_t prop;
-    if (xcb_icccm_get_wm_name_reply(conn, cookie, &prop, 0)) {
-        if (prop.format == 8) {
-            mName = String(prop.name, prop.name_len);
-        } else {
-            mName.clear();
-        }
-        xcb_icccm_get_text_property_reply_wipe(&prop);
+    if (reply && reply->type != XCB_NONE && reply->format == 8) {
+        mName = String(static_cast<const char*>(xcb_get_property_value(reply)), xcb_get_property_value_length(reply));
     } else {
         mName.clear();
     }
 }
 
-void Client::updateProtocols(xcb_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateProtocols(xcb_get_property_reply_t* reply)
 {
     mProtocols.clear();
-    xcb_icccm_get_wm_protocols_reply_t prop;
-    if (xcb_icccm_get_wm_protocols_reply(conn, cookie, &prop, 0)) {
-        for (uint32_t i = 0; i < prop.atoms_len; ++i) {
-            mProtocols.insert(prop.atoms[i]);
-        }
-        xcb_icccm_get_wm_protocols_reply_wipe(&prop);
+    int count;
+    const xcb_atom_t* atoms = atomsFromReply(reply, &count);
+    for (int i = 0; i < count; ++i) {
+        mProtocols.insert(atoms[i]);
     }
 }
 
-void Client::updateStrut(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateStrut(xcb_get_property_reply_t* reply)
 {
     memset(&mStrut, '\0', sizeof(mStrut));
     xcb_ewmh_get_extents_reply_t struts;
-    if (xcb_ewmh_get_wm_strut_reply(conn, cookie, &struts, 0)) {
+    if (reply && xcb_ewmh_get_extents_from_reply(&struts, reply)) {
         mStrut.left = struts.left;
         mStrut.right = struts.right;
         mStrut.top = struts.top;
@@ -342,49 +612,48 @@ void Client::updateStrut(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t
     }
 }
 
-void Client::updatePartialStrut(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updatePartialStrut(xcb_get_property_reply_t* reply)
 {
-    if (!xcb_ewmh_get_wm_strut_partial_reply(conn, cookie, &mStrut, 0)) {
+    if (!reply || !xcb_ewmh_get_wm_strut_partial_from_reply(&mStrut, reply)) {
         memset(&mStrut, '\0', sizeof(mStrut));
     }
 }
 
-void Client::updateEwmhState(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateEwmhState(xcb_get_property_reply_t* reply)
 {
     warning() << "updating ewmh state";
     mEwmhState.clear();
-    xcb_ewmh_get_atoms_reply_t prop;
-    if (xcb_ewmh_get_wm_state_reply(conn, cookie, &prop, 0)) {
-        for (uint32_t i = 0; i < prop.atoms_len; ++i) {
-            warning() << "ewmh state has" << Atoms::name(prop.atoms[i]);
-            mEwmhState.insert(prop.atoms[i]);
-        }
-        xcb_ewmh_get_atoms_reply_wipe(&prop);
+    int count;
+    const xcb_atom_t* atoms = atomsFromReply(reply, &count);
+    for (int i = 0; i < count; ++i) {
+        warning() << "ewmh state has" << Atoms::name(atoms[i]);
+        mEwmhState.insert(atoms[i]);
     }
 }
 
-void Client::updateWindowTypes(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updateWindowTypes(xcb_get_property_reply_t* reply)
 {
     mWindowTypes.clear();
-    xcb_ewmh_get_atoms_reply_t prop;
-    if (xcb_ewmh_get_wm_window_type_reply(conn, cookie, &prop, 0)) {
-        for (uint32_t i = 0; i < prop.atoms_len; ++i) {
-            warning() << "window type has" << Atoms::name(prop.atoms[i]);
-            mWindowTypes.append(prop.atoms[i]);
-        }
-        xcb_ewmh_get_atoms_reply_wipe(&prop);
+    int count;
+    const xcb_atom_t* atoms = atomsFromReply(reply, &count);
+    // the list is in order of preference, the first type we know wins
+    mWindowType = count ? XCB_ATOM_NONE : AtomSet::atom(AtomSet::TypeNormal);
+    for (int i = 0; i < count; ++i) {
+        warning() << "window type has" << Atoms::name(atoms[i]);
+        if (mWindowTypes.insert(atoms[i]) && mWindowType == XCB_ATOM_NONE)
+            mWindowType = atoms[i];
     }
 
-    if (mWindowTypes.contains(conn->_NET_WM_WINDOW_TYPE_DIALOG) && mTransientFor == XCB_NONE) {
+    if (mWindowTypes.contains(AtomSet::TypeDialog) && mTransientFor == XCB_NONE) {
         if (mGroup->leader() != mWindow) {
             mTransientFor = mGroup->leader();
         }
     }
 }
 
-void Client::updatePid(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie)
+void Client::updatePid(xcb_get_property_reply_t* reply)
 {
-    if (!xcb_ewmh_get_wm_pid_reply(conn, cookie, &mPid, 0))
+    if (!reply || !xcb_ewmh_get_wm_pid_from_reply(&mPid, reply))
         mPid = 0;
 }
 
@@ -435,6 +704,10 @@ Client *Client::create(const Rect& rect, int screenNumber, const String &clazz,
     ptr->mRect = rect;
     ptr->mOwned = true;
     ptr->mScreenNumber = screenNumber;
+    ptr->mNormalHints = wmNormalHints;
+    ptr->mWmHints = wmHints;
+    ptr->mClass.className = clazz;
+    ptr->mClass.instanceName = instance;
     ptr->init();
     ptr->mNoFocus = true;
     Workspace *ws = wm->activeWorkspace(screenNumber);
@@ -446,6 +719,7 @@ Client *Client::create(const Rect& rect, int screenNumber, const String &clazz,
     ptr->complete();
 
     sClients[window] = ptr;
+    wm->windows().insert(window, WindowRegistry::OwnedWindow, ptr, screenNumber);
     return ptr;
 }
 
@@ -458,9 +732,8 @@ Client *Client::manage(xcb_window_t window, int screenNumber)
     WindowManager *wm = WindowManager::instance();
     wm->js().onClient(ptr);
 
-    xcb_ewmh_connection_t* ewmhConn = wm->ewmhConnection();
     bool focus = false;
-    if (!ptr->mEwmhState.contains(ewmhConn->_NET_WM_STATE_STICKY)) {
+    if (!ptr->mEwmhState.contains(AtomSet::StateSticky)) {
         Workspace *ws = wm->activeWorkspace(screenNumber);
         assert(ws);
         ptr->mWorkspace = ws;
@@ -468,25 +741,157 @@ Client *Client::manage(xcb_window_t window, int screenNumber)
         focus = true;
     }
     ptr->complete();
+    sClients[window] = ptr;
+    wm->windows().insert(window, WindowRegistry::ClientWindow, ptr, screenNumber);
+    // focus() wants the protocols, they ride along with the title
+    ptr->prefetch(LazyName|LazyProtocols);
     if (focus)
         ptr->focus();
-
-    sClients[window] = ptr;
     return ptr;
 }
 
+void Client::adopt(const List<std::pair<xcb_window_t, int> > &windows, const Upgrade *upgrade)
+{
+    if (windows.isEmpty())
+        return;
+    WindowManager *wm = WindowManager::instance();
+    xcb_connection_t* conn = wm->connection();
+    const int count = windows.size();
+
+    Hash<xcb_window_t, const Upgrade::ClientState*> saved;
+    if (upgrade) {
+        for (const Upgrade::ClientState &state : upgrade->clients)
+            saved[state.window] = &state;
+    }
+
+    // everything for every window goes out before the first reply is read,
+    // the struts are cheap enough to ask for up front. Windows handed over
+    // by an upgrade already know everything
+    List<Client*> clients;
+    List<const Upgrade::ClientState*> states;
+    List<StateRequest> requests(count);
+    clients.reserve(count);
+    states.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Client *client = new Client(windows.at(i).first);
+        client->mScreenNumber = windows.at(i).second;
+        states.append(saved.value(client->mWindow));
+        if (!states.at(i))
+            client->requestState(&requests[i], LazyStrut);
+        clients.append(client);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (states.at(i)) {
+            clients.at(i)->restore(*states.at(i));
+        } else {
+            clients.at(i)->readState(requests.at(i));
+        }
+        wm->bindings().rebind(clients.at(i)->mWindow);
+    }
+
+    // no round trips from here on
+    List<xcb_window_t> roots;
+    for (int i = 0; i < count; ++i) {
+        Client *client = clients.at(i);
+        wm->js().onClient(client);
+        const Upgrade::ClientState *state = states.at(i);
+        if (state ? state->workspace != -1 : !client->mEwmhState.contains(AtomSet::StateSticky)) {
+            Workspace *ws = wm->activeWorkspace(client->mScreenNumber);
+            if (state)
+                ws = wm->workspaces(client->mScreenNumber).value(state->workspace, ws);
+            assert(ws);
+            client->mWorkspace = ws;
+            ws->addClient(client);
+        }
+        // an upgrade keeps the placement the previous binary came up with
+        if (!state)
+            client->place();
+        client->createFrame();
+        if (!roots.contains(client->root()))
+            roots.append(client->root());
+    }
+    {
+        ServerGrabScope grabScope(conn);
+        const uint32_t noValue[] = { 0 };
+        for (xcb_window_t root : roots)
+            xcb_change_window_attributes(conn, root, XCB_CW_EVENT_MASK, noValue);
+        for (Client *client : clients)
+            client->reparent();
+        const uint32_t rootEvent[] = { Types::RootEventMask };
+        for (xcb_window_t root : roots)
+            xcb_change_window_attributes(conn, root, XCB_CW_EVENT_MASK, rootEvent);
+    }
+
+    // manage() would have focused each of them in turn, leaving the last one
+    // focused and the rest in reverse order behind it. After an upgrade the
+    // window manager puts the old focus order back instead
+    Client *focus = 0;
+    for (Client *client : clients) {
+        client->finish();
+        sClients[client->mWindow] = client;
+        wm->windows().insert(client->mWindow, WindowRegistry::ClientWindow, client, client->mScreenNumber);
+        client->prefetch(LazyName|LazyProtocols);
+        if (client->mWorkspace && !upgrade) {
+            client->mWorkspace->updateFocus(client);
+            focus = client;
+        }
+    }
+    if (focus)
+        focus->focus();
+    warning() << "adopted" << count << "windows";
+}
+
+void Client::snapshot(Upgrade::ClientState *state) const
+{
+    state->window = mWindow;
+    state->leader = mGroup ? mGroup->leader() : XCB_NONE;
+    state->transientFor = mTransientFor;
+    state->windowType = mWindowType;
+    state->sizeHints = mNormalHints;
+    state->screen = mScreenNumber;
+    state->workspace = mWorkspace ? WindowManager::instance()->workspaces(mScreenNumber).indexOf(mWorkspace) : -1;
+    state->rect = mRect;
+    state->noFocus = mNoFocus;
+    state->movable = mMovable;
+    state->className = mClass.className;
+    state->instanceName = mClass.instanceName;
+    state->windowTypes = mWindowTypes.atoms();
+    state->ewmhState = mEwmhState.atoms();
+    if (!mData.isInvalid() && !mData.isUndefined())
+        state->data = mData.toJSON();
+}
+
+void Client::restore(const Upgrade::ClientState &state)
+{
+    mGroup = ClientGroup::clientGroup(state.leader ? state.leader : mWindow);
+    mGroup->add(this);
+    mTransientFor = state.transientFor;
+    mWindowType = state.windowType;
+    mNormalHints = state.sizeHints;
+    mRect = state.rect;
+    mNoFocus = state.noFocus;
+    mMovable = state.movable;
+    mClass.className = state.className;
+    mClass.instanceName = state.instanceName;
+    for (xcb_atom_t atom : state.windowTypes)
+        mWindowTypes.insert(atom);
+    for (xcb_atom_t atom : state.ewmhState)
+        mEwmhState.insert(atom);
+    if (!state.data.isEmpty())
+        mData = Value::fromJSON(state.data);
+}
+
 Client *Client::client(xcb_window_t window)
 {
-    return sClients.value(window);
+    const WindowRegistry::Entry entry = WindowManager::instance()->windows().find(window);
+    if (entry.kind == WindowRegistry::ClientWindow || entry.kind == WindowRegistry::OwnedWindow)
+        return entry.client;
+    return 0;
 }
 
 Client *Client::clientByFrame(xcb_window_t frame)
 {
-    for (const auto it : sClients) {
-        if (it.second->mFrame == frame)
-            return it.second;
-    }
-    return 0;
+    return WindowManager::instance()->windows().client(frame, WindowRegistry::FrameWindow);
 }
 
 void Client::setBackgroundColor(const Color& color)
@@ -538,33 +943,86 @@ void Client::unmap()
     xcb_unmap_window(conn, mWindow);
 }
 
+void Client::hide()
+{
+    HideMode mode = mHideMode;
+    if (mode == HideDefault)
+        mode = mWorkspace ? mWorkspace->hideMode() : HideUnmap;
+    if (mode == HideUnmap) {
+        unmap();
+        return;
+    }
+    if (mParked || !mFrame)
+        return;
+    // just past the left edge of every screen, the size stays the same so
+    // the client has no reason to redraw
+    mParked = true;
+    xcb_connection_t* conn = WindowManager::instance()->connection();
+    const uint16_t mask = XCB_CONFIG_WINDOW_X|XCB_CONFIG_WINDOW_Y;
+    const uint32_t values[2] = { static_cast<uint32_t>(parkedX()), static_cast<uint32_t>(mRect.y) };
+    xcb_configure_window(conn, mFrame, mask, values);
+}
+
+void Client::show()
+{
+    if (mParked) {
+        mParked = false;
+        xcb_connection_t* conn = WindowManager::instance()->connection();
+        const uint16_t mask = XCB_CONFIG_WINDOW_X|XCB_CONFIG_WINDOW_Y;
+        const uint32_t values[2] = { static_cast<uint32_t>(mRect.x), static_cast<uint32_t>(mRect.y) };
+        xcb_configure_window(conn, mFrame, mask, values);
+    }
+    map();
+}
+
 void Client::focus()
 {
-    const bool takeFocus = mProtocols.count(Atoms::WM_TAKE_FOCUS) > 0;
+    // a client that doesn't take input only gets focus if it wants
+    // WM_TAKE_FOCUS, so those can't go on without the protocols. Everyone
+    // else gets focus right away and the message once the protocols arrive
+    // rather than blocking on them
+    if (mNoFocus)
+        load(LazyProtocols);
+    const bool known = (mLoaded & LazyProtocols) != 0;
+    const bool takeFocus = known && mProtocols.contains(AtomSet::ProtocolTakeFocus);
     if (mNoFocus && !takeFocus)
         return;
     WindowManager *wm = WindowManager::instance();
-    if (takeFocus) {
-        xcb_client_message_event_t event;
-        memset(&event, '\0', sizeof(event));
-        event.response_type = XCB_CLIENT_MESSAGE;
-        event.window = mWindow;
-        event.format = 32;
-        event.type = Atoms::WM_PROTOCOLS;
-        event.data.data32[0] = Atoms::WM_TAKE_FOCUS;
-        event.data.data32[1] = wm->timestamp();
-
-        xcb_send_event(wm->connection(), false, mWindow, XCB_EVENT_MASK_NO_EVENT,
-                       reinterpret_cast<char*>(&event));
+    mTakeFocusPending = true;
+    wm->setFocusedClient(this);
+    if (known) {
+        sendTakeFocus();
+    } else {
+        prefetch(LazyProtocols);
     }
     xcb_set_input_focus(wm->connection(), XCB_INPUT_FOCUS_PARENT, mWindow, wm->timestamp());
     //error() << "Setting input focus to client" << mWindow << mClass.className;
     xcb_ewmh_set_active_window(wm->ewmhConnection(), mScreenNumber, mWindow);
-    wm->setFocusedClient(this);
     if (mWorkspace)
         mWorkspace->updateFocus(this);
 }
 
+void Client::sendTakeFocus()
+{
+    mTakeFocusPending = false;
+    WindowManager *wm = WindowManager::instance();
+    // focus may have moved on while we were waiting for the protocols
+    if (wm->focusedClient() != this || !mProtocols.contains(AtomSet::ProtocolTakeFocus))
+        return;
+    xcb_client_message_event_t event;
+    memset(&event, '\0', sizeof(event));
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.window = mWindow;
+    event.format = 32;
+    event.type = Atoms::WM_PROTOCOLS;
+    event.data.data32[0] = Atoms::WM_TAKE_FOCUS;
+    event.data.data32[1] = wm->timestamp();
+
+    xcb_send_event(wm->connection(), false, mWindow, XCB_EVENT_MASK_NO_EVENT,
+                   reinterpret_cast<char*>(&event));
+    wm->scheduleFlush();
+}
+
 void Client::restack(xcb_stack_mode_t stackMode, Client *sibling)
 {
     warning() << "raising" << this;
@@ -583,7 +1041,13 @@ void Client::resize(const Size& size)
     xcb_connection_t* conn = WindowManager::instance()->connection();
     const uint16_t mask = XCB_CONFIG_WINDOW_WIDTH|XCB_CONFIG_WINDOW_HEIGHT;
     const uint32_t values[2] = { static_cast<uint32_t>(size.width), static_cast<uint32_t>(size.height) };
-    xcb_configure_window(conn, mFrame, mask, values);
+    if (mParked) {
+        // how far off screen it's parked depends on the width
+        const uint32_t parked[3] = { static_cast<uint32_t>(parkedX()), values[0], values[1] };
+        xcb_configure_window(conn, mFrame, XCB_CONFIG_WINDOW_X|mask, parked);
+    } else {
+        xcb_configure_window(conn, mFrame, mask, values);
+    }
     xcb_configure_window(conn, mWindow, mask, values);
 }
 
@@ -592,7 +1056,8 @@ void Client::move(const Point& point)
     warning() << "move" << point << this;
     mRect.x = point.x;
     mRect.y = point.y;
-    if (!mFrame)
+    // show() puts a parked frame where it belongs
+    if (!mFrame || mParked)
         return;
 
     xcb_connection_t* conn = WindowManager::instance()->connection();
@@ -605,12 +1070,10 @@ void Client::close()
 {
     WindowManager *wm = WindowManager::instance();
     if (mOwned) {
-        EventLoop::eventLoop()->callLater([this, wm] {
-                delete this;
-                xcb_flush(wm->connection());
-            });
+        destroyLater();
     } else {
-        if (mProtocols.contains(Atoms::WM_DELETE_WINDOW)) {
+        load(LazyProtocols);
+        if (mProtocols.contains(AtomSet::ProtocolDeleteWindow)) {
             // delete
             xcb_client_message_event_t event;
             memset(&event, '\0', sizeof(event));
@@ -632,6 +1095,7 @@ void Client::close()
 
 bool Client::kill(int sig)
 {
+    load(LazyPid);
     if (!mPid)
         return false;
     return (::kill(mPid, sig) == 0);
@@ -658,14 +1122,12 @@ void Client::configure()
 bool Client::shouldLayout()
 {
 #warning handle transient-for here
-    xcb_ewmh_connection_t* conn = WindowManager::instance()->ewmhConnection();
-    return windowType() == conn->_NET_WM_WINDOW_TYPE_NORMAL;
+    return mWindowType == AtomSet::atom(AtomSet::TypeNormal);
 }
 
 bool Client::isFloating() const
 {
-    xcb_ewmh_connection_t* conn = WindowManager::instance()->ewmhConnection();
-    return windowType() != conn->_NET_WM_WINDOW_TYPE_NORMAL;
+    return mWindowType != AtomSet::atom(AtomSet::TypeNormal);
 }
 
 void Client::expose(const Rect& rect)
@@ -695,84 +1157,71 @@ xcb_visualtype_t* Client::visual() const
 void Client::setRect(const Rect &rect)
 {
     mRect = rect;
+    if (!mFrame)
+        return;
 
     xcb_connection_t* conn = WindowManager::instance()->connection();
     const uint16_t mask = (XCB_CONFIG_WINDOW_X|XCB_CONFIG_WINDOW_Y
                            |XCB_CONFIG_WINDOW_WIDTH|XCB_CONFIG_WINDOW_HEIGHT);
     const uint32_t values[4] = { static_cast<uint32_t>(rect.x), static_cast<uint32_t>(rect.y),
                                  static_cast<uint32_t>(rect.width), static_cast<uint32_t>(rect.height) };
-    xcb_configure_window(conn, mFrame, mask, values);
+    if (mParked) {
+        // stays parked, show() moves it
+        const uint32_t parked[4] = { static_cast<uint32_t>(parkedX()), values[1], values[2], values[3] };
+        xcb_configure_window(conn, mFrame, mask, parked);
+    } else {
+        xcb_configure_window(conn, mFrame, mask, values);
+    }
+    // the client fills its frame
+    xcb_configure_window(conn, mWindow, XCB_CONFIG_WINDOW_WIDTH|XCB_CONFIG_WINDOW_HEIGHT, values + 2);
 }
 
 void Client::propertyNotify(xcb_atom_t atom)
 {
 #warning Need to notify js that properties have changed
     warning() << "Got propertyNotify" << Atoms::name(atom) << mWindow;
-    auto ewmhConnection = WindowManager::instance()->ewmhConnection();
-    auto conn = ewmhConnection->connection;
-    if (atom == XCB_ATOM_WM_NORMAL_HINTS) {
-        const xcb_get_property_cookie_t normalHintsCookie = xcb_icccm_get_wm_normal_hints(conn, mWindow);
-        updateNormalHints(conn, normalHintsCookie);
-    } else if (atom == XCB_ATOM_WM_TRANSIENT_FOR) {
-        const xcb_get_property_cookie_t transientCookie = xcb_icccm_get_wm_transient_for(conn, mWindow);
-        updateTransient(conn, transientCookie);
-    } else if (atom == Atoms::WM_CLIENT_LEADER) {
-        const xcb_get_property_cookie_t leaderCookie = xcb_get_property(conn, 0, mWindow, Atoms::WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 1);
-        updateLeader(conn, leaderCookie);
-    } else if (atom == XCB_ATOM_WM_HINTS) {
-        const xcb_get_property_cookie_t hintsCookie = xcb_icccm_get_wm_hints(conn, mWindow);
-        updateHints(conn, hintsCookie);
-    } else if (atom == XCB_ATOM_WM_CLASS) {
-        const xcb_get_property_cookie_t classCookie = xcb_icccm_get_wm_class(conn, mWindow);
-        updateClass(conn, classCookie);
-    } else if (atom == XCB_ATOM_WM_NAME) {
-        const xcb_get_property_cookie_t nameCookie = xcb_icccm_get_wm_name(conn, mWindow);
-        updateName(conn, nameCookie);
-    } else if (atom == Atoms::WM_PROTOCOLS) {
-        const xcb_get_property_cookie_t protocolsCookie = xcb_icccm_get_wm_protocols(conn, mWindow, Atoms::WM_PROTOCOLS);
-        updateProtocols(conn, protocolsCookie);
-    } else if (atom == ewmhConnection->_NET_WM_STRUT) {
-        const xcb_get_property_cookie_t strutCookie = xcb_ewmh_get_wm_strut(ewmhConnection, mWindow);
-        updateStrut(ewmhConnection, strutCookie);
-    } else if (atom == ewmhConnection->_NET_WM_STRUT_PARTIAL) {
-        const xcb_get_property_cookie_t partialStrutCookie = xcb_ewmh_get_wm_strut_partial(ewmhConnection, mWindow);
-        updatePartialStrut(ewmhConnection, partialStrutCookie);
-    } else if (atom == ewmhConnection->_NET_WM_STATE) {
-        const xcb_get_property_cookie_t stateCookie = xcb_ewmh_get_wm_state(ewmhConnection, mWindow);
-        updateEwmhState(ewmhConnection, stateCookie);
-    } else if (atom == ewmhConnection->_NET_WM_WINDOW_TYPE) {
-        const xcb_get_property_cookie_t typeCookie = xcb_ewmh_get_wm_window_type(ewmhConnection, mWindow);
-        updateWindowTypes(ewmhConnection, typeCookie);
-    } else if (atom == ewmhConnection->_NET_WM_PID) {
-        const xcb_get_property_cookie_t pidCookie = xcb_ewmh_get_wm_pid(ewmhConnection, mWindow);
-        updatePid(ewmhConnection, pidCookie);
-    } else {
-        warning() << "Unhandled propertyNotify atom" << Atoms::name(atom);
+    xcb_atom_t atoms[5] = { atom };
+    int count = 1;
+    if (const unsigned prop = lazyProperty(atom)) {
+        // nobody has looked at it yet, the next load() picks up the new value
+        if (!((mLoaded | mFetching) & prop))
+            return;
+        mLoaded &= ~prop;
+        mFetching |= prop;
+        // both struts are refetched so the partial one still wins
+        count = lazyAtoms(prop, atoms);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (mDirtyProperties.contains(atoms[i]))
+            continue;
+        if (mDirtyProperties.isEmpty())
+            sDirtyClients.append(mWindow);
+        mDirtyProperties.append(atoms[i]);
     }
 }
 
-xcb_atom_t Client::windowType() const
+void Client::refreshProperties()
 {
-    xcb_ewmh_connection_t* ewmhConn = WindowManager::instance()->ewmhConnection();
-    if (mWindowTypes.isEmpty())
-        return ewmhConn->_NET_WM_WINDOW_TYPE_NORMAL;
-
-    for (auto type : mWindowTypes) {
-        if (type == ewmhConn->_NET_WM_WINDOW_TYPE_DESKTOP
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_DOCK
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_TOOLBAR
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_MENU
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_UTILITY
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_SPLASH
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_DIALOG
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_DROPDOWN_MENU
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_POPUP_MENU
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_TOOLTIP
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_NOTIFICATION
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_COMBO
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_DND
-            || type == ewmhConn->_NET_WM_WINDOW_TYPE_NORMAL)
-            return type;
-    }
-    return XCB_ATOM_NONE;
+    if (sDirtyClients.isEmpty())
+        return;
+    Replies& replies = WindowManager::instance()->replies();
+    for (xcb_window_t window : sDirtyClients) {
+        Client *client = Client::client(window);
+        if (!client)
+            continue;
+        for (xcb_atom_t atom : client->mDirtyProperties) {
+            xcb_get_property_cookie_t cookie;
+            if (!client->requestProperty(atom, &cookie)) {
+                warning() << "Unhandled propertyNotify atom" << Atoms::name(atom);
+                continue;
+            }
+            replies.wait<xcb_get_property_reply_t>(cookie, [window, atom](xcb_get_property_reply_t* reply, xcb_generic_error_t*) {
+                    // the client may have gone away in the meantime
+                    if (Client *client = Client::client(window))
+                        client->updateProperty(atom, reply);
+                });
+        }
+        client->mDirtyProperties.clear();
+    }
+    sDirtyClients.clear();
 }
@@ -1,9 +1,13 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include "AtomSet.h"
 #include "ClientGroup.h"
 #include "Graphics.h"
+#include "IntrusiveList.h"
+#include "Pool.h"
 #include "Rect.h"
+#include "Upgrade.h"
 #include <rct/Hash.h>
 #include <rct/Set.h>
 #include <rct/Value.h>
@@ -23,6 +27,9 @@ public:
     static Client *clientByFrame(xcb_window_t frame);
 
     static Client *manage(xcb_window_t window, int screenNumber);
+    // manages windows that existed before we did, see WindowManager::manage()
+    static void adopt(const List<std::pair<xcb_window_t, int> > &windows, const Upgrade *upgrade = 0);
+    void snapshot(Upgrade::ClientState *state) const;
     static Client *create(const Rect& rect,
                           int screenNumber,
                           const String &clazz,
@@ -30,6 +37,17 @@ public:
                           bool movable);
     static void clear() { sClients.clear(); }
 
+    // clients come out of a pool, see poolStats()
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
+    static const PoolStats &poolStats();
+
+    // for DestroyNotify, the client stops resolving right away and is deleted
+    // by reap() together with the others destroyed in the same batch
+    void destroyLater();
+    static void reap();
+    static bool isReaping() { return sReaping; }
+
     static Hash<xcb_window_t, Client*> &clients() { return sClients; }
 
     void setBackgroundColor(const Color& color);
@@ -54,6 +72,7 @@ public:
     bool isDialog() const { return mTransientFor != XCB_NONE; }
 
     bool hasUserSpecifiedPosition() const { return mNormalHints.flags & (XCB_ICCCM_SIZE_HINT_P_POSITION|XCB_ICCCM_SIZE_HINT_US_POSITION); }
+    const xcb_size_hints_t &normalHints() const { return mNormalHints; }
     bool hasUserSpecifiedSize() const { return mNormalHints.flags & (XCB_ICCCM_SIZE_HINT_US_SIZE|XCB_ICCCM_SIZE_HINT_P_SIZE); }
 
     bool isFloating() const;
@@ -71,20 +90,38 @@ public:
     xcb_visualtype_t* visual() const;
     int screenNumber() const { return mScreenNumber; }
 
-    String wmName() const { return mName; }
+    String wmName() { load(LazyName); return mName; }
     String instanceName() const { return mClass.instanceName; }
     String className() const { return mClass.className; }
 
     bool isOwned() const { return mOwned; }
 
+    // How the client is kept out of sight while its workspace isn't active.
+    // Parking moves the frame offscreen and leaves it mapped, so that the
+    // toolkit keeps its buffers and has nothing to repaint when it comes
+    // back. HideDefault goes with whatever the workspace says
+    enum HideMode { HideDefault, HideUnmap, HidePark };
+    HideMode hideMode() const { return mHideMode; }
+    void setHideMode(HideMode mode) { mHideMode = mode; }
+    void hide();
+    void show();
+    bool isParked() const { return mParked; }
+
     bool isMovable() const { return mMovable || isFloating(); }
     void setMovable(bool movable) { error() << "movable set to" << movable << "for" << mClass.className; mMovable = movable; }
 
     Rect rect() const { return mRect; }
     void setRect(const Rect &rect);
 
+    // whatever the JS side wants to keep with the client, survives upgrades
+    const Value& data() const { return mData; }
+    void setData(const Value &data) { mData = data; }
+
+    // marks the property dirty, refreshProperties() fetches everything that
+    // was marked during the event batch in one go
     void propertyNotify(xcb_atom_t atom);
-    xcb_atom_t windowType() const;
+    static void refreshProperties();
+    xcb_atom_t windowType() const { return mWindowType; }
 private:
     void clearWorkspace();
     bool updateWorkspace(Workspace* workspace);
@@ -95,27 +132,70 @@ private:
     Client(xcb_window_t win);
     void init();
     void complete();
+    // the steps of complete(), adopt() runs each of them for all clients
+    void place();
+    void createFrame();
+    void reparent();
+    void finish();
 
     void updateState(xcb_ewmh_connection_t* conn);
-    void updateSize(xcb_connection_t* conn, xcb_get_geometry_cookie_t cookie);
-    void updateNormalHints(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateTransient(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateHints(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateClass(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateName(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateProtocols(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateStrut(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updatePartialStrut(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateEwmhState(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateWindowTypes(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updateLeader(xcb_connection_t* conn, xcb_get_property_cookie_t cookie);
-    void updatePid(xcb_ewmh_connection_t* conn, xcb_get_property_cookie_t cookie);
+    struct StateRequest {
+        enum { MaxAtoms = 12 };
+        xcb_get_geometry_cookie_t geometry;
+        int count;
+        xcb_atom_t atoms[MaxAtoms];
+        xcb_get_property_cookie_t cookies[MaxAtoms];
+    };
+    // lazy properties can ride along when they're cheap to ask for
+    void requestState(StateRequest *request, unsigned lazy = 0) const;
+    void readState(const StateRequest &request);
+    void restore(const Upgrade::ClientState &state);
+
+    // properties that aren't needed to classify and place a window are only
+    // fetched on first use or in the background once the window is managed,
+    // and kept until a PropertyNotify says otherwise
+    enum LazyProperty {
+        LazyName = 0x1,
+        LazyPid = 0x2,
+        LazyProtocols = 0x4,
+        LazyStrut = 0x8,
+        AllLazy = 0xf
+    };
+    static unsigned lazyProperty(xcb_atom_t atom);
+    static int lazyAtoms(unsigned props, xcb_atom_t* atoms);
+    void load(unsigned props);
+    void prefetch(unsigned props);
+    void sendTakeFocus();
+    // just past the left edge of every screen, see hide()
+    int32_t parkedX() const { return -(mRect.width + ParkMargin); }
+
+    bool requestProperty(xcb_atom_t atom, xcb_get_property_cookie_t* cookie) const;
+    void updateProperty(xcb_atom_t atom, xcb_get_property_reply_t* reply);
+
+    void updateSize(xcb_get_geometry_reply_t* reply);
+    void updateNormalHints(xcb_get_property_reply_t* reply);
+    void updateTransient(xcb_get_property_reply_t* reply);
+    void updateHints(xcb_get_property_reply_t* reply);
+    void updateClass(xcb_get_property_reply_t* reply);
+    void updateName(xcb_get_property_reply_t* reply);
+    void updateProtocols(xcb_get_property_reply_t* reply);
+    void updateStrut(xcb_get_property_reply_t* reply);
+    void updatePartialStrut(xcb_get_property_reply_t* reply);
+    void updateEwmhState(xcb_get_property_reply_t* reply);
+    void updateWindowTypes(xcb_get_property_reply_t* reply);
+    void updateLeader(xcb_get_property_reply_t* reply);
+    void updatePid(xcb_get_property_reply_t* reply);
 
 private:
     xcb_window_t mWindow;
     xcb_window_t mFrame;
     bool mNoFocus, mOwned, mMovable;
+    HideMode mHideMode;
+    bool mParked; // mRect still has where it goes when shown
+    bool mLayoutPending; // waiting for mWorkspace to be shown
+    enum { ParkMargin = 64 }; // between a parked frame and the screen
     Workspace* mWorkspace;
+    IntrusiveNode<Client> mFocusNode; // in mWorkspace's focus order
     Graphics* mGraphics;
 
     Rect mRect;
@@ -127,16 +207,24 @@ private:
         String className;
     } mClass;
     String mName;
-    Set<xcb_atom_t> mProtocols;
-    Set<xcb_atom_t> mEwmhState;
-    List<xcb_atom_t> mWindowTypes;
+    AtomSet mProtocols;
+    AtomSet mEwmhState;
+    AtomSet mWindowTypes;
+    xcb_atom_t mWindowType; // the first type we know, cached for the hot paths
     xcb_ewmh_wm_strut_partial_t mStrut;
     ClientGroup *mGroup;
     Value mJSValue;
+    Value mData;
     uint32_t mPid;
     int mScreenNumber;
+    unsigned mLoaded, mFetching;
+    bool mTakeFocusPending;
+    List<xcb_atom_t> mDirtyProperties;
 
     static Hash<xcb_window_t, Client*> sClients;
+    static List<xcb_window_t> sDirtyClients;
+    static List<Client*> sDoomed;
+    static bool sReaping;
 
     friend class Workspace;
 };
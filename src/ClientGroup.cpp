@@ -4,6 +4,24 @@
 #include "Workspace.h"
 
 Map<xcb_window_t, ClientGroup*> ClientGroup::sGroups;
+static Pool<ClientGroup> sPool;
+
+void *ClientGroup::operator new(size_t size)
+{
+    assert(size == sizeof(ClientGroup));
+    (void)size;
+    return sPool.allocate();
+}
+
+void ClientGroup::operator delete(void *ptr)
+{
+    sPool.release(ptr);
+}
+
+const PoolStats &ClientGroup::poolStats()
+{
+    return sPool.stats();
+}
 
 void ClientGroup::restack(Client *client, xcb_stack_mode_t stackMode, Client *sibling)
 {
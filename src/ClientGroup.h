@@ -1,6 +1,7 @@
 #ifndef CLIENTGROUP_H
 #define CLIENTGROUP_H
 
+#include "Pool.h"
 #include <rct/List.h>
 #include <rct/Map.h>
 #include <memory>
@@ -14,6 +15,10 @@ class ClientGroup
 public:
     inline ~ClientGroup();
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
+    static const PoolStats &poolStats();
+
     static ClientGroup *clientGroup(xcb_window_t leader);
     void add(Client *client) { mClients.append(client); }
     const List<Client*> clients() const { return mClients; }
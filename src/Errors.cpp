@@ -0,0 +1,38 @@
+#include "Errors.h"
+#include <rct/Log.h>
+#include <assert.h>
+
+Errors::Errors()
+{
+}
+
+void Errors::expect(unsigned int sequence, const Handler &handler)
+{
+    assert(handler);
+    mHandlers[sequence] = handler;
+}
+
+void Errors::retire(unsigned int sequence)
+{
+    if (mHandlers.isEmpty())
+        return;
+    // errors arrive ahead of anything the server sends after processing
+    // the request, so whatever is older than this event went through fine
+    mHandlers.erase(mHandlers.begin(), mHandlers.lower_bound(sequence));
+}
+
+void Errors::handle(const xcb_generic_error_t *error)
+{
+    ++mCounts[key(error->major_code, error->error_code)];
+    retire(error->full_sequence);
+    auto it = mHandlers.find(error->full_sequence);
+    if (it == mHandlers.end()) {
+        warning() << "X error" << static_cast<int>(error->error_code)
+                  << "for request" << static_cast<int>(error->major_code)
+                  << "minor" << error->minor_code << "resource" << error->resource_id;
+        return;
+    }
+    const Handler handler = it->second;
+    mHandlers.erase(it);
+    handler(error);
+}
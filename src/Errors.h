@@ -0,0 +1,43 @@
+#ifndef ERRORS_H
+#define ERRORS_H
+
+#include <rct/Hash.h>
+#include <rct/Map.h>
+#include <xcb/xcb.h>
+#include <functional>
+
+// Routes X errors for requests without replies to whoever sent them, so that
+// nobody has to block in xcb_request_check. The request is sent unchecked and
+// its sequence registered with expect(); the error then comes in with the
+// events and is handed to the callback. Once the server has moved past a
+// sequence without complaining the callback is dropped.
+//
+// Every error is counted by request and error code, routed or not.
+class Errors
+{
+public:
+    typedef std::function<void(const xcb_generic_error_t *error)> Handler;
+
+    Errors();
+
+    void expect(unsigned int sequence, const Handler &handler);
+    void expect(xcb_void_cookie_t cookie, const Handler &handler) { expect(cookie.sequence, handler); }
+
+    // the server has processed every request before sequence
+    void retire(unsigned int sequence);
+    void handle(const xcb_generic_error_t *error);
+    void clear() { mHandlers.clear(); }
+
+    int pending() const { return mHandlers.size(); }
+
+    static uint16_t key(uint8_t majorCode, uint8_t errorCode) { return (majorCode << 8) | errorCode; }
+    static uint8_t majorCode(uint16_t key) { return key >> 8; }
+    static uint8_t errorCode(uint16_t key) { return key & 0xff; }
+    const Hash<uint16_t, int>& counts() const { return mCounts; }
+
+private:
+    Map<unsigned int, Handler> mHandlers;
+    Hash<uint16_t, int> mCounts;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "EventBatch.h"
+#include <algorithm>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+EventBatch::EventBatch()
+    : mCursor(0), mInputCursor(0), mMotion(-1), mEnter(-1), mCoalesced(0), mShortLived(0)
+{
+}
+
+EventBatch::~EventBatch()
+{
+}
+
+void EventBatch::clear()
+{
+    // keeps the capacity around for the next batch
+    mArena.clear();
+    mSlots.clear();
+    mInput.clear();
+    mCursor = mInputCursor = 0;
+    mConfigureRequests.clear();
+    mExposes.clear();
+    mMapRequests.clear();
+    mUnmaps.clear();
+    mProperties.clear();
+    mMotion = mEnter = -1;
+    mCoalesced = mShortLived = 0;
+    mStats = Stats();
+}
+
+void EventBatch::drop(int idx)
+{
+    assert(mSlots.at(idx) != Empty);
+    mSlots[idx] = Empty;
+    ++mCoalesced;
+}
+
+int EventBatch::copy(const xcb_generic_event_t *event)
+{
+    size_t size = sizeof(xcb_generic_event_t);
+    if ((event->response_type & ~0x80) == XCB_GE_GENERIC)
+        size += reinterpret_cast<const xcb_ge_generic_event_t*>(event)->length * 4;
+    const int words = (size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    const int offset = mArena.size();
+    if (offset + words > static_cast<int>(mArena.capacity()))
+        ++mStats.grows;
+    mArena.resize(offset + words);
+    memcpy(mArena.data() + offset, event, size);
+    mStats.bytes += words * sizeof(uint64_t);
+    return offset;
+}
+
+static inline void mergeConfigureRequest(xcb_configure_request_event_t *into, const xcb_configure_request_event_t *from)
+{
+    // the newer request wins for every field it sets, the older one fills in the rest
+    uint16_t missing = from->value_mask & ~into->value_mask;
+    if (into->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+        // a sibling only makes sense together with the stack mode it came with
+        missing &= ~XCB_CONFIG_WINDOW_SIBLING;
+    }
+    if (missing & XCB_CONFIG_WINDOW_X)
+        into->x = from->x;
+    if (missing & XCB_CONFIG_WINDOW_Y)
+        into->y = from->y;
+    if (missing & XCB_CONFIG_WINDOW_WIDTH)
+        into->width = from->width;
+    if (missing & XCB_CONFIG_WINDOW_HEIGHT)
+        into->height = from->height;
+    if (missing & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+        into->border_width = from->border_width;
+    if (missing & XCB_CONFIG_WINDOW_SIBLING)
+        into->sibling = from->sibling;
+    if (missing & XCB_CONFIG_WINDOW_STACK_MODE)
+        into->stack_mode = from->stack_mode;
+    into->value_mask |= missing;
+}
+
+static inline void mergeExpose(xcb_expose_event_t *into, const xcb_expose_event_t *from)
+{
+    const int x1 = std::min(into->x, from->x);
+    const int y1 = std::min(into->y, from->y);
+    const int x2 = std::max(into->x + into->width, from->x + from->width);
+    const int y2 = std::max(into->y + into->height, from->y + from->height);
+    into->x = x1;
+    into->y = y1;
+    into->width = x2 - x1;
+    into->height = y2 - y1;
+    into->count = from->count;
+}
+
+bool EventBatch::dropMapRequest(xcb_window_t window)
+{
+    const auto it = mMapRequests.find(window);
+    if (it == mMapRequests.end())
+        return false;
+    const bool pending = at(it->second);
+    if (pending) {
+        drop(it->second);
+        ++mShortLived;
+    }
+    mMapRequests.erase(it);
+    return pending;
+}
+
+bool EventBatch::coalesce(xcb_generic_event_t *event, int idx)
+{
+    switch (event->response_type & ~0x80) {
+    case XCB_MOTION_NOTIFY:
+        if (mMotion != -1 && at(mMotion))
+            drop(mMotion);
+        mMotion = idx;
+        break;
+    case XCB_ENTER_NOTIFY:
+        if (mEnter != -1 && at(mEnter))
+            drop(mEnter);
+        mEnter = idx;
+        break;
+    case XCB_CONFIGURE_REQUEST: {
+        xcb_configure_request_event_t *request = reinterpret_cast<xcb_configure_request_event_t*>(event);
+        const auto it = mConfigureRequests.find(request->window);
+        if (it != mConfigureRequests.end() && at(it->second)) {
+            mergeConfigureRequest(request, reinterpret_cast<xcb_configure_request_event_t*>(at(it->second)));
+            drop(it->second);
+        }
+        mConfigureRequests[request->window] = idx;
+        break; }
+    case XCB_PROPERTY_NOTIFY: {
+        const xcb_property_notify_event_t *notify = reinterpret_cast<xcb_property_notify_event_t*>(event);
+        const uint64_t k = key(notify->window, notify->atom);
+        const auto it = mProperties.find(k);
+        if (it != mProperties.end() && at(it->second))
+            drop(it->second);
+        mProperties[k] = idx;
+        break; }
+    case XCB_EXPOSE: {
+        const xcb_expose_event_t *expose = reinterpret_cast<xcb_expose_event_t*>(event);
+        const auto it = mExposes.find(expose->window);
+        if (it != mExposes.end() && at(it->second)) {
+            mergeExpose(reinterpret_cast<xcb_expose_event_t*>(at(it->second)), expose);
+            ++mCoalesced;
+            return true;
+        }
+        mExposes[expose->window] = idx;
+        break; }
+    case XCB_MAP_REQUEST: {
+        const xcb_map_request_event_t *request = reinterpret_cast<xcb_map_request_event_t*>(event);
+        const auto it = mMapRequests.find(request->window);
+        if (it != mMapRequests.end() && at(it->second)) {
+            // still mapped as far as this batch is concerned
+            ++mCoalesced;
+            return true;
+        }
+        mMapRequests[request->window] = idx;
+        mUnmaps.remove(request->window);
+        break; }
+    case XCB_UNMAP_NOTIFY: {
+        const xcb_unmap_notify_event_t *notify = reinterpret_cast<xcb_unmap_notify_event_t*>(event);
+        const auto it = mUnmaps.find(notify->window);
+        if (it != mUnmaps.end()) {
+            const xcb_unmap_notify_event_t *prev = reinterpret_cast<xcb_unmap_notify_event_t*>(at(it->second));
+            if (prev && prev->event == notify->event) {
+                ++mCoalesced;
+                return true;
+            }
+        }
+        mUnmaps[notify->window] = idx;
+        // withdrawn before we got to the map request, nothing to manage
+        dropMapRequest(notify->window);
+        break; }
+    case XCB_DESTROY_NOTIFY: {
+        const xcb_destroy_notify_event_t *notify = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
+        // a window that comes and goes within the batch is never managed and
+        // its requests would only fail
+        if (dropMapRequest(notify->window)) {
+            const auto it = mConfigureRequests.find(notify->window);
+            if (it != mConfigureRequests.end() && at(it->second))
+                drop(it->second);
+        }
+        // nothing after this may be folded into events from before the destroy
+        mConfigureRequests.remove(notify->window);
+        mExposes.remove(notify->window);
+        mUnmaps.remove(notify->window);
+        break; }
+    default:
+        break;
+    }
+    return false;
+}
+
+void EventBatch::add(xcb_generic_event_t *event, Priority priority)
+{
+    assert(event);
+    const int idx = mSlots.size();
+    if (!coalesce(event, idx)) {
+        if (mSlots.size() == static_cast<int>(mSlots.capacity()))
+            ++mStats.grows;
+        mSlots.append(copy(event));
+        if (priority == Input)
+            mInput.append(idx);
+    }
+    free(event);
+}
+
+const xcb_generic_event_t *EventBatch::takeInput()
+{
+    while (mInputCursor < mInput.size()) {
+        const int idx = mInput.at(mInputCursor++);
+        if (const xcb_generic_event_t *event = at(idx)) {
+            mSlots[idx] = Empty;
+            return event;
+        }
+    }
+    return 0;
+}
+
+const xcb_generic_event_t *EventBatch::take()
+{
+    while (mCursor < mSlots.size()) {
+        if (const xcb_generic_event_t *event = at(mCursor)) {
+            mSlots[mCursor++] = Empty;
+            return event;
+        }
+        ++mCursor;
+    }
+    return 0;
+}
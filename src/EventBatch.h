@@ -0,0 +1,76 @@
+#ifndef EVENTBATCH_H
+#define EVENTBATCH_H
+
+#include <rct/Hash.h>
+#include <rct/List.h>
+#include <xcb/xcb.h>
+
+// Collects the events read from the X connection in one go and folds
+// redundant ones as they are added. Folded events leave an empty slot behind
+// so that adding stays O(1) regardless of how large the batch gets.
+//
+// Events are copied into an arena that is reused from one batch to the next,
+// the event passed to add() is freed right away. Events handed out by take()
+// point into the arena and stay valid until the batch is cleared.
+//
+// Events added as Input are handed out by takeInput() ahead of everything
+// else, the rest come out of take() in arrival order.
+class EventBatch
+{
+public:
+    EventBatch();
+    ~EventBatch();
+
+    enum Priority { Normal, Input };
+    void add(xcb_generic_event_t *event, Priority priority = Normal);
+    void clear();
+
+    const xcb_generic_event_t *takeInput();
+    const xcb_generic_event_t *take();
+
+    bool isEmpty() const { return mSlots.isEmpty(); }
+    bool atEnd() const { return mCursor >= mSlots.size() && mInputCursor >= mInput.size(); }
+    int size() const { return mSlots.size(); }
+    int pending() const { return mSlots.size() - mCursor; }
+
+    int coalesced() const { return mCoalesced; }
+    // map requests dropped because the window went away later in the batch
+    int shortLived() const { return mShortLived; }
+
+    // arena usage of the current batch
+    struct Stats {
+        Stats()
+            : bytes(0), grows(0)
+        {}
+
+        int bytes, grows;
+    };
+    const Stats& stats() const { return mStats; }
+
+private:
+    enum { Empty = -1 };
+    xcb_generic_event_t *at(int idx) const
+    {
+        const int offset = mSlots.at(idx);
+        return offset == Empty ? 0 : reinterpret_cast<xcb_generic_event_t*>(const_cast<uint64_t*>(mArena.data()) + offset);
+    }
+    int copy(const xcb_generic_event_t *event);
+    void drop(int idx);
+    bool coalesce(xcb_generic_event_t *event, int idx);
+    bool dropMapRequest(xcb_window_t window);
+
+    static uint64_t key(uint32_t a, uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; }
+
+private:
+    List<uint64_t> mArena;
+    List<int> mSlots; // offset into the arena in words, or Empty
+    List<int> mInput;
+    int mCursor, mInputCursor;
+    Hash<xcb_window_t, int> mConfigureRequests, mExposes, mMapRequests, mUnmaps;
+    Hash<uint64_t, int> mProperties;
+    int mMotion, mEnter;
+    int mCoalesced, mShortLived;
+    Stats mStats;
+};
+
+#endif
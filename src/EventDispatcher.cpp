@@ -0,0 +1,34 @@
+#include "EventDispatcher.h"
+#include <rct/Log.h>
+
+EventDispatcher::EventDispatcher()
+    : mTrace(false)
+{
+}
+
+void EventDispatcher::setHandler(uint8_t type, const char *name, Handler handler)
+{
+    Entry &entry = mEntries[type & ~0x80];
+    entry.name = name;
+    entry.handler = handler;
+}
+
+void EventDispatcher::addHook(uint8_t type, const Hook &hook)
+{
+    mEntries[type & ~0x80].hooks.append(hook);
+}
+
+void EventDispatcher::updateTrace()
+{
+    mTrace = testLog(Warning);
+}
+
+void EventDispatcher::trace(uint8_t type) const
+{
+    const Entry &entry = mEntries[type];
+    if (entry.handler) {
+        warning() << entry.name;
+    } else {
+        warning() << "unhandled event" << static_cast<int>(type);
+    }
+}
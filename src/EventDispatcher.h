@@ -0,0 +1,74 @@
+#ifndef EVENTDISPATCHER_H
+#define EVENTDISPATCHER_H
+
+#include "nwm-config.h"
+#include "RoundTrips.h"
+#include <rct/List.h>
+#include <xcb/xcb.h>
+#include <functional>
+
+// Maps X event response types to their handlers. Core events are registered
+// up front, extension events once their event base is known.
+//
+// Hooks run before the handler of their event type. Tracing is compiled in
+// with NWM_EVENT_TRACE and then only costs a predicted branch unless logging
+// is verbose enough to show it.
+class EventDispatcher
+{
+public:
+    typedef void (*Handler)(const xcb_generic_event_t *event);
+    typedef std::function<void(const xcb_generic_event_t *event)> Hook;
+
+    EventDispatcher();
+
+    void setHandler(uint8_t type, const char *name, Handler handler);
+    void addHook(uint8_t type, const Hook &hook);
+    void clearHooks(uint8_t type) { mEntries[type & ~0x80].hooks.clear(); }
+
+    // picks up the current log level
+    void updateTrace();
+
+    const char *name(uint8_t type) const { return mEntries[type & ~0x80].name; }
+
+    void dispatch(const xcb_generic_event_t *event) const
+    {
+        const uint8_t type = event->response_type & ~0x80;
+        const Entry &entry = mEntries[type];
+#ifdef NWM_EVENT_TRACE
+        if (__builtin_expect(mTrace, false))
+            trace(type);
+#endif
+        const RoundTrips::Handler roundTrips(entry.name);
+        if (__builtin_expect(!entry.hooks.isEmpty(), false)) {
+            for (const Hook &hook : entry.hooks)
+                hook(event);
+        }
+        if (entry.handler)
+            entry.handler(event);
+    }
+
+    // turns a handler for a specific event struct into a table entry
+    template <typename T, void (*Func)(const T *)>
+    static void handler(const xcb_generic_event_t *event)
+    {
+        Func(reinterpret_cast<const T *>(event));
+    }
+
+private:
+    void trace(uint8_t type) const __attribute__((noinline, cold));
+
+private:
+    struct Entry {
+        Entry()
+            : name(0), handler(0)
+        {}
+
+        const char *name;
+        Handler handler;
+        List<Hook> hooks;
+    };
+    Entry mEntries[0x80];
+    bool mTrace;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "EventReader.h"
+#include <rct/Log.h>
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+EventReader::EventReader()
+    : mHead(0), mTail(0), mConn(0), mWakeFd(-1), mKickFd(-1), mStop(false)
+{
+    memset(mRing, 0, sizeof(mRing));
+}
+
+EventReader::~EventReader()
+{
+    stop();
+}
+
+bool EventReader::start(xcb_connection_t *conn)
+{
+    assert(!isRunning());
+    mConn = conn;
+    mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    mKickFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mWakeFd == -1 || mKickFd == -1) {
+        error() << "Unable to create eventfd for the event reader" << strerror(errno);
+        stop();
+        return false;
+    }
+    mStop = false;
+    mThread = std::thread(&EventReader::run, this);
+    return true;
+}
+
+void EventReader::stop()
+{
+    if (mThread.joinable()) {
+        mStop = true;
+        kick();
+        mThread.join();
+    }
+    while (xcb_generic_event_t *event = take())
+        free(event);
+    for (xcb_generic_event_t *event : mBacklog)
+        free(event);
+    mBacklog.clear();
+    if (mWakeFd != -1) {
+        ::close(mWakeFd);
+        mWakeFd = -1;
+    }
+    if (mKickFd != -1) {
+        ::close(mKickFd);
+        mKickFd = -1;
+    }
+}
+
+static inline void notify(int fd)
+{
+    const uint64_t one = 1;
+    int ret;
+    do {
+        ret = ::write(fd, &one, sizeof(one));
+    } while (ret == -1 && errno == EINTR);
+}
+
+static inline void drain(int fd)
+{
+    uint64_t value;
+    int ret;
+    do {
+        ret = ::read(fd, &value, sizeof(value));
+    } while (ret == -1 && errno == EINTR);
+}
+
+void EventReader::acknowledge()
+{
+    drain(mWakeFd);
+}
+
+void EventReader::kick()
+{
+    if (mKickFd != -1)
+        notify(mKickFd);
+}
+
+void EventReader::wake()
+{
+    notify(mWakeFd);
+}
+
+xcb_generic_event_t *EventReader::take()
+{
+    const unsigned int tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire))
+        return 0;
+    xcb_generic_event_t *event = mRing[tail & (Capacity - 1)];
+    mTail.store(tail + 1, std::memory_order_release);
+    return event;
+}
+
+bool EventReader::push(xcb_generic_event_t *event)
+{
+    const unsigned int head = mHead.load(std::memory_order_relaxed);
+    if (head - mTail.load(std::memory_order_acquire) == Capacity)
+        return false;
+    mRing[head & (Capacity - 1)] = event;
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void EventReader::run()
+{
+    pollfd fds[2];
+    fds[0].fd = xcb_get_file_descriptor(mConn);
+    fds[0].events = POLLIN;
+    fds[1].fd = mKickFd;
+    fds[1].events = POLLIN;
+
+    while (!mStop) {
+        fds[0].revents = fds[1].revents = 0;
+        // a backlog means the ring is full, check back regularly for room
+        const int ret = ::poll(fds, 2, mBacklog.isEmpty() ? -1 : 1);
+        if (ret == -1 && errno != EINTR) {
+            error() << "Event reader poll failed" << strerror(errno);
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+            drain(mKickFd);
+        if (mStop)
+            break;
+
+        // reading the socket also pulls in replies, the main thread needs to
+        // know about those even if there are no events
+        bool read = (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+        xcb_generic_event_t *event;
+        while ((event = read ? xcb_poll_for_event(mConn) : xcb_poll_for_queued_event(mConn))) {
+            if (!mBacklog.isEmpty()) {
+                const xcb_generic_event_t *last = mBacklog.back();
+                if ((event->response_type & ~0x80) == XCB_MOTION_NOTIFY
+                    && (last->response_type & ~0x80) == XCB_MOTION_NOTIFY) {
+                    // nobody is going to look at the older one anyway
+                    free(mBacklog.back());
+                    mBacklog.back() = event;
+                    continue;
+                }
+            }
+            mBacklog.append(event);
+            read = true;
+        }
+        bool pushed = false;
+        while (!mBacklog.isEmpty() && push(mBacklog.front())) {
+            mBacklog.removeFirst();
+            pushed = true;
+        }
+
+        if (read || pushed)
+            wake();
+        if (xcb_connection_has_error(mConn)) {
+            // the main thread picks this up
+            wake();
+            break;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef EVENTREADER_H
+#define EVENTREADER_H
+
+#include <rct/LinkedList.h>
+#include <xcb/xcb.h>
+#include <atomic>
+#include <thread>
+
+// Optionally drains the X connection on a thread of its own so that a busy
+// main thread (typically a slow JS handler) doesn't let the socket fill up
+// and stall the server. Events are handed over through a single producer,
+// single consumer ring and the main loop is woken through an eventfd.
+//
+// Replies stay with xcb, the reader only makes sure they get read; the main
+// thread is woken for those as well so that reply continuations run.
+class EventReader
+{
+public:
+    EventReader();
+    ~EventReader();
+
+    bool start(xcb_connection_t *conn);
+    void stop();
+    bool isRunning() const { return mThread.joinable(); }
+
+    // for the main loop to wait on
+    int fd() const { return mWakeFd; }
+    void acknowledge();
+
+    // main thread only, the caller owns the event
+    xcb_generic_event_t *take();
+
+    // the main thread may have read events into xcb's queue while waiting
+    // for a reply, have the reader pick them up
+    void kick();
+
+private:
+    void run();
+    bool push(xcb_generic_event_t *event);
+    void wake();
+
+    enum { Capacity = 4096 }; // power of two
+    xcb_generic_event_t *mRing[Capacity];
+    std::atomic<unsigned int> mHead, mTail;
+
+    xcb_connection_t *mConn;
+    int mWakeFd, mKickFd;
+    std::atomic<bool> mStop;
+    std::thread mThread;
+
+    // reader thread only, what didn't fit in the ring
+    LinkedList<xcb_generic_event_t*> mBacklog;
+};
+
+#endif
@@ -4,6 +4,26 @@
 #if defined(HAVE_CAIRO) && defined(HAVE_PANGO)
 #include <cairo-xcb.h>
 #endif
+#include <assert.h>
+
+static Pool<Graphics, 16> sPool;
+
+void *Graphics::operator new(size_t size)
+{
+    assert(size == sizeof(Graphics));
+    (void)size;
+    return sPool.allocate();
+}
+
+void Graphics::operator delete(void *ptr)
+{
+    sPool.release(ptr);
+}
+
+const PoolStats &Graphics::poolStats()
+{
+    return sPool.stats();
+}
 
 Graphics::Graphics(Client *client)
 #if defined(HAVE_CAIRO) && defined(HAVE_PANGO)
@@ -46,7 +66,7 @@ void Graphics::redraw()
         cairo_translate(mCairo, -mTextRect.x, -mTextRect.y);
     }
     WindowManager* wm = WindowManager::instance();
-    xcb_flush(wm->connection());
+    wm->scheduleFlush();
 #endif
 }
 
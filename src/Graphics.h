@@ -2,6 +2,7 @@
 #define GRAPHICS_H
 
 #include "nwm-config.h"
+#include "Pool.h"
 #include "Rect.h"
 #include <rct/String.h>
 #include <memory>
@@ -44,6 +45,10 @@ public:
     Graphics(Client *client);
     ~Graphics();
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
+    static const PoolStats &poolStats();
+
     void redraw();
 
     void setBackgroundColor(const Color& color) { mBackgroundColor = color; }
@@ -8,6 +8,73 @@
 
 namespace Handlers {
 
+void releaseGrab(xcb_connection_t* conn, xcb_timestamp_t time)
+{
+    // ungrab pointer and keyboard
+    Errors& errors = WindowManager::instance()->errors();
+    errors.expect(xcb_ungrab_pointer(conn, time), [](const xcb_generic_error_t*) {
+            // we're done
+            error() << "Unable to ungrab pointer after successfully grabing (release)";
+            abort();
+        });
+    errors.expect(xcb_ungrab_keyboard(conn, time), [](const xcb_generic_error_t*) {
+            // we're done
+            error() << "Unable to ungrab keyboard after successfully grabing (release)";
+            abort();
+        });
+}
+
+static void grabForMove(xcb_connection_t* conn, const xcb_button_press_event_t* event)
+{
+    // grab both the keyboard and the pointer, the pointer stays frozen until
+    // we know whether that worked
+    const xcb_window_t window = event->event;
+    const xcb_window_t root = event->root;
+    const xcb_timestamp_t time = event->time;
+    const Point origin(event->root_x, event->root_y);
+    Replies& replies = WindowManager::instance()->replies();
+    const xcb_grab_pointer_cookie_t pointerCookie = xcb_grab_pointer(conn, false, root,
+                                                                     XCB_EVENT_MASK_BUTTON_RELEASE
+                                                                     | XCB_EVENT_MASK_POINTER_MOTION,
+                                                                     XCB_GRAB_MODE_ASYNC,
+                                                                     XCB_GRAB_MODE_ASYNC,
+                                                                     XCB_NONE, XCB_NONE,
+                                                                     XCB_CURRENT_TIME);
+    replies.wait<xcb_grab_pointer_reply_t>(pointerCookie, [conn, window, root, time, origin](xcb_grab_pointer_reply_t* pointerReply, xcb_generic_error_t*) {
+            if (!pointerReply) {
+                error() << "Unable to grab pointer for move";
+                xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, time);
+                return;
+            }
+            const xcb_grab_keyboard_cookie_t keyboardCookie = xcb_grab_keyboard(conn, false, root,
+                                                                                XCB_CURRENT_TIME,
+                                                                                XCB_GRAB_MODE_ASYNC,
+                                                                                XCB_GRAB_MODE_ASYNC);
+            WindowManager::instance()->replies().wait<xcb_grab_keyboard_reply_t>(keyboardCookie, [conn, window, time, origin](xcb_grab_keyboard_reply_t* keyboardReply, xcb_generic_error_t*) {
+                    if (!keyboardReply) {
+                        // bad!
+                        error() << "Unable to grab keyboard for move";
+                        // ungrab pointer and move on
+                        WindowManager::instance()->errors().expect(xcb_ungrab_pointer(conn, time), [](const xcb_generic_error_t*) {
+                                // we're done
+                                error() << "Unable to ungrab pointer after successfully grabing";
+                                abort();
+                            });
+                        xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, time);
+                        return;
+                    }
+                    WindowManager *wm = WindowManager::instance();
+                    if (Client *client = Client::client(window)) {
+                        wm->startMoving(client, origin);
+                    } else {
+                        // gone while we were waiting
+                        releaseGrab(conn, time);
+                    }
+                    xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, time);
+                });
+        });
+}
+
 void handleButtonPress(const xcb_button_press_event_t* event)
 {
     WindowManager *wm = WindowManager::instance();
@@ -20,46 +87,13 @@ void handleButtonPress(const xcb_button_press_event_t* event)
         client->raise();
         if (wm->focusPolicy() == WindowManager::FocusClick)
             client->focus();
-        xcb_flush(conn);
+        wm->scheduleFlush();
 
         if (event->state) {
             const uint16_t mod = wm->moveModifierMask();
             if (mod && (event->state & mod) == mod && client->isMovable()) {
-                // grab both the keyboard and the pointer
-                xcb_grab_pointer_cookie_t pointerCookie = xcb_grab_pointer(conn, false, event->root,
-                                                                           XCB_EVENT_MASK_BUTTON_RELEASE
-                                                                           | XCB_EVENT_MASK_POINTER_MOTION,
-                                                                           XCB_GRAB_MODE_ASYNC,
-                                                                           XCB_GRAB_MODE_ASYNC,
-                                                                           XCB_NONE, XCB_NONE,
-                                                                           XCB_CURRENT_TIME);
-                xcb_grab_pointer_reply_t* pointerReply = xcb_grab_pointer_reply(conn, pointerCookie, 0);
-                if (!pointerReply) {
-                    error() << "Unable to grab pointer for move";
-                    xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, event->time);
-                    return;
-                }
-                free(pointerReply);
-                xcb_grab_keyboard_cookie_t keyboardCookie = xcb_grab_keyboard(conn, false, event->root,
-                                                                              XCB_CURRENT_TIME,
-                                                                              XCB_GRAB_MODE_ASYNC,
-                                                                              XCB_GRAB_MODE_ASYNC);
-                xcb_grab_keyboard_reply_t* keyboardReply = xcb_grab_keyboard_reply(conn, keyboardCookie, 0);
-                if (!keyboardReply) {
-                    // bad!
-                    error() << "Unable to grab keyboard for move";
-                    // ungrab pointer and move on
-                    xcb_void_cookie_t ungrabCookie = xcb_ungrab_pointer(conn, event->time);
-                    if (xcb_request_check(conn, ungrabCookie)) {
-                        // we're done
-                        error() << "Unable to ungrab pointer after successfully grabing";
-                        abort();
-                    }
-                    xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, event->time);
-                    return;
-                }
-                free(keyboardReply);
-                wm->startMoving(client, Point(event->root_x, event->root_y));
+                grabForMove(conn, event);
+                return;
             }
             xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, event->time);
             return;
@@ -69,23 +103,6 @@ void handleButtonPress(const xcb_button_press_event_t* event)
     }
 }
 
-static inline void releaseGrab(xcb_connection_t* conn, xcb_timestamp_t time)
-{
-    // ungrab pointer and keyboard
-    xcb_void_cookie_t ungrabCookie = xcb_ungrab_pointer(conn, time);
-    if (xcb_request_check(conn, ungrabCookie)) {
-        // we're done
-        error() << "Unable to ungrab pointer after successfully grabing (release)";
-        abort();
-    }
-    ungrabCookie = xcb_ungrab_keyboard(conn, time);
-    if (xcb_request_check(conn, ungrabCookie)) {
-        // we're done
-        error() << "Unable to ungrab keyboard after successfully grabing (release)";
-        abort();
-    }
-}
-
 void handleButtonRelease(const xcb_button_release_event_t* event)
 {
     WindowManager *wm = WindowManager::instance();
@@ -122,14 +139,8 @@ void handleMotionNotify(const xcb_motion_notify_event_t* event)
 
 static inline int screenFromWindow(xcb_window_t win)
 {
-    WindowManager* wm = WindowManager::instance();
-    int scrn = wm->screenNumber(win);
-    if (scrn != -1)
-        return scrn;
-    Client *client = Client::client(win);
-    if (client)
-        return client->screenNumber();
-    return -1;
+    // roots, client windows and frames all know their screen
+    return WindowManager::instance()->windows().screen(win);
 }
 
 void handleClientMessage(const xcb_client_message_event_t* event)
@@ -154,7 +165,6 @@ void handleClientMessage(const xcb_client_message_event_t* event)
         if (ws >= static_cast<uint32_t>(wss.size()))
             return;
         wss[ws]->activate();
-        xcb_ewmh_set_current_desktop(ewmhConn, scrn, ws);
     }
 }
 
@@ -168,9 +178,8 @@ void handleConfigureRequest(const xcb_configure_request_event_t* event)
         if (event->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) {
             Client *sibling = 0;
             if (event->value_mask & XCB_CONFIG_WINDOW_SIBLING) {
-                sibling = Client::client(event->sibling);
-                if (!sibling)
-                    sibling = Client::clientByFrame(event->sibling);
+                // the sibling can be a client window or a frame
+                sibling = WindowManager::instance()->windows().client(event->sibling);
             }
             client->restack(static_cast<xcb_stack_mode_t>(event->stack_mode), sibling);
         }
@@ -222,7 +231,9 @@ void handleDestroyNotify(const xcb_destroy_notify_event_t* event)
 {
     Client *client = Client::client(event->window);
     if (client) {
-        delete client;
+        client->destroyLater();
+    } else {
+        WindowManager::instance()->cancelManage(event->window);
     }
 }
 
@@ -285,27 +296,40 @@ void handleMappingNotify(const xcb_mapping_notify_event_t* event)
 
 void handleMapRequest(const xcb_map_request_event_t* event)
 {
-    xcb_connection_t* conn = WindowManager::instance()->connection();
-    const xcb_get_window_attributes_cookie_t cookie = xcb_get_window_attributes_unchecked(conn, event->window);
-    const xcb_query_tree_cookie_t treeCookie = xcb_query_tree(conn, event->window);
-    AutoPointer<xcb_get_window_attributes_reply_t> reply(xcb_get_window_attributes_reply(conn, cookie, 0));
-    AutoPointer<xcb_query_tree_reply_t> treeReply(xcb_query_tree_reply(conn, treeCookie, 0));
-
-    if (!reply || !treeReply)
-        return;
-    if (reply->override_redirect) {
-        error() << "override_redirect";
-        return;
-    }
-    error() << "managing?";
-    Client *client = Client::client(event->window);
-    if (client) {
-        // stuff
-    } else {
-        client = Client::manage(event->window, WindowManager::instance()->screenNumber(treeReply->root));
-        // more stuff
-    }
-    client->map();
+    WindowManager *wm = WindowManager::instance();
+    xcb_connection_t* conn = wm->connection();
+    const xcb_window_t window = event->window;
+    if (!Client::client(window))
+        wm->expectManage(window);
+    const xcb_get_window_attributes_cookie_t cookie = xcb_get_window_attributes_unchecked(conn, window);
+    const xcb_query_tree_cookie_t treeCookie = xcb_query_tree(conn, window);
+    wm->replies().wait<xcb_get_window_attributes_reply_t>(cookie, [conn, window, treeCookie](xcb_get_window_attributes_reply_t* reply, xcb_generic_error_t*) {
+            if (!reply || reply->override_redirect) {
+                if (reply)
+                    error() << "override_redirect";
+                WindowManager::instance()->cancelManage(window);
+                xcb_discard_reply(conn, treeCookie.sequence);
+                return;
+            }
+            WindowManager::instance()->replies().wait<xcb_query_tree_reply_t>(treeCookie, [window](xcb_query_tree_reply_t* treeReply, xcb_generic_error_t*) {
+                    WindowManager *wm = WindowManager::instance();
+                    Client *client = Client::client(window);
+                    // gone again before the replies came in, don't bother
+                    // with a frame
+                    if (!client && !wm->takeManage(window))
+                        return;
+                    if (!treeReply)
+                        return;
+                    error() << "managing?";
+                    if (client) {
+                        // stuff
+                    } else {
+                        client = Client::manage(window, wm->screenNumber(treeReply->root));
+                        // more stuff
+                    }
+                    client->map();
+                });
+        });
 }
 
 void handlePropertyNotify(const xcb_property_notify_event_t* event)
@@ -331,6 +355,9 @@ void handleUnmapNotify(const xcb_unmap_notify_event_t* event)
     Client *client = Client::client(event->event);
     if (client) {
         client->unmap();
+    } else {
+        // withdrawn before we got around to managing it
+        wm->cancelManage(event->window);
     }
 }
 
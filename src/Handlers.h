@@ -19,6 +19,8 @@ void handleMappingNotify(const xcb_mapping_notify_event_t* event);
 void handleMapRequest(const xcb_map_request_event_t* event);
 void handlePropertyNotify(const xcb_property_notify_event_t* event);
 void handleUnmapNotify(const xcb_unmap_notify_event_t* event);
+// ends the pointer and keyboard grab a move started
+void releaseGrab(xcb_connection_t* conn, xcb_timestamp_t time);
 }; // namespace Handlers
 
 #endif
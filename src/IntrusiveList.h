@@ -0,0 +1,174 @@
+#ifndef INTRUSIVELIST_H
+#define INTRUSIVELIST_H
+
+#include <assert.h>
+#include <iterator>
+
+// The links an object needs to be in an IntrusiveList, embedded in the object
+// itself. An object can be in one list per node it has.
+template <typename T>
+struct IntrusiveNode {
+    IntrusiveNode()
+        : prev(0), next(0), list(0)
+    {}
+
+    T *prev, *next;
+    const void *list;
+};
+
+// Doubly linked list threaded through the objects it holds, so that moving
+// an object to the front, removing it and finding its neighbours are all
+// O(1) without a lookup first. The list doesn't own its objects, an object
+// has to be removed before it's deleted.
+template <typename T, IntrusiveNode<T> T::*Node>
+class IntrusiveList
+{
+public:
+    IntrusiveList()
+        : mFirst(0), mLast(0), mSize(0)
+    {}
+    ~IntrusiveList()
+    {
+        while (mFirst)
+            remove(mFirst);
+    }
+
+    int size() const { return mSize; }
+    bool isEmpty() const { return !mSize; }
+
+    T *first() const { return mFirst; }
+    T *last() const { return mLast; }
+    T *next(const T *t) const { assert(contains(t)); return (t->*Node).next; }
+    T *prev(const T *t) const { assert(contains(t)); return (t->*Node).prev; }
+
+    bool contains(const T *t) const { return t && (t->*Node).list == this; }
+
+    // walks from whichever end is closer, 0 if idx is out of range
+    T *at(int idx) const
+    {
+        if (idx < 0 || idx >= mSize)
+            return 0;
+        T *t;
+        if (idx < mSize / 2) {
+            t = mFirst;
+            while (idx--)
+                t = (t->*Node).next;
+        } else {
+            t = mLast;
+            for (int i = mSize - 1; i > idx; --i)
+                t = (t->*Node).prev;
+        }
+        return t;
+    }
+    int indexOf(const T *t) const
+    {
+        if (!contains(t))
+            return -1;
+        int idx = 0;
+        for (const T *cur = mFirst; cur != t; cur = (cur->*Node).next)
+            ++idx;
+        return idx;
+    }
+
+    void prepend(T *t)
+    {
+        link(t, 0, mFirst);
+    }
+    void append(T *t)
+    {
+        link(t, mLast, 0);
+    }
+    void moveToFront(T *t)
+    {
+        assert(contains(t));
+        if (t == mFirst)
+            return;
+        remove(t);
+        prepend(t);
+    }
+    bool remove(T *t)
+    {
+        if (!contains(t))
+            return false;
+        IntrusiveNode<T> &node = t->*Node;
+        if (node.prev) {
+            (node.prev->*Node).next = node.next;
+        } else {
+            mFirst = node.next;
+        }
+        if (node.next) {
+            (node.next->*Node).prev = node.prev;
+        } else {
+            mLast = node.prev;
+        }
+        node.prev = node.next = 0;
+        node.list = 0;
+        --mSize;
+        return true;
+    }
+
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        // dereferencing hands out the pointer by value, std::reverse_iterator
+        // dereferences a temporary copy of us
+        typedef T *value_type;
+        typedef int difference_type;
+        typedef T *const *pointer;
+        typedef T *reference;
+
+        const_iterator(const IntrusiveList *list = 0, T *t = 0)
+            : mList(list), mCurrent(t)
+        {}
+
+        T *operator*() const { return mCurrent; }
+        const_iterator &operator++() { mCurrent = (mCurrent->*Node).next; return *this; }
+        const_iterator operator++(int) { const_iterator ret = *this; ++*this; return ret; }
+        const_iterator &operator--() { mCurrent = mCurrent ? (mCurrent->*Node).prev : mList->mLast; return *this; }
+        const_iterator operator--(int) { const_iterator ret = *this; --*this; return ret; }
+        bool operator==(const const_iterator &other) const { return mCurrent == other.mCurrent; }
+        bool operator!=(const const_iterator &other) const { return mCurrent != other.mCurrent; }
+
+    private:
+        const IntrusiveList *mList;
+        T *mCurrent;
+    };
+    typedef const_iterator iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    const_iterator begin() const { return const_iterator(this, mFirst); }
+    const_iterator end() const { return const_iterator(this, 0); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+    void link(T *t, T *prev, T *next)
+    {
+        assert(t);
+        IntrusiveNode<T> &node = t->*Node;
+        assert(!node.list);
+        node.prev = prev;
+        node.next = next;
+        node.list = this;
+        if (prev) {
+            (prev->*Node).next = t;
+        } else {
+            mFirst = t;
+        }
+        if (next) {
+            (next->*Node).prev = t;
+        } else {
+            mLast = t;
+        }
+        ++mSize;
+    }
+
+    IntrusiveList(const IntrusiveList &) = delete;
+    IntrusiveList &operator=(const IntrusiveList &) = delete;
+
+    T *mFirst, *mLast;
+    int mSize;
+};
+
+#endif
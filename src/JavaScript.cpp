@@ -46,6 +46,36 @@ static T readChild(const Value &array, int idx, bool &ok, unsigned int flags = 0
     return readValue<T>(array[idx], ok, flags, defaultValue);
 }
 
+static inline Value fromHideMode(Client::HideMode mode)
+{
+    switch (mode) {
+    case Client::HideUnmap:
+        return "unmap";
+    case Client::HidePark:
+        return "park";
+    case Client::HideDefault:
+        break;
+    }
+    return "default";
+}
+
+static inline bool toHideMode(const Value &value, Client::HideMode *mode)
+{
+    if (!value.isString())
+        return false;
+    const String str = value.toString();
+    if (str == "default") {
+        *mode = Client::HideDefault;
+    } else if (str == "unmap") {
+        *mode = Client::HideUnmap;
+    } else if (str == "park") {
+        *mode = Client::HidePark;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 template <> inline Color convertValue<Color>(const Value &value, bool &ok)
 {
     if (value.isUndefined()) {
@@ -131,7 +161,7 @@ template <> inline Font convertValue<Font>(const Value &value, bool &ok)
 }
 
 JavaScript::JavaScript()
-    : ScriptEngine()
+    : ScriptEngine(), mStaging(false)
 {
 }
 
@@ -153,7 +183,7 @@ static inline Value fromSize(const Size &size)
     return ret;
 }
 
-bool JavaScript::init(String *err)
+void JavaScript::setup()
 {
     // --------------- Client class ---------------
     mClientClass = Class::create("Client");
@@ -186,6 +216,10 @@ bool JavaScript::init(String *err)
                     return Value(WindowManager::instance()->focusedClient() == client);
                 if (prop == "movable")
                     return client->isMovable();
+                if (prop == "data")
+                    return client->data();
+                if (prop == "hideMode")
+                    return fromHideMode(client->hideMode());
                 if (prop == "workspace") {
                     Workspace* ws = client->workspace();
                     if (!ws)
@@ -212,6 +246,15 @@ bool JavaScript::init(String *err)
                     return instance()->throwException<Value>("Client.movable needs to be a boolean");
                 if (Client *client = obj->extraData<Client*>())
                     client->setMovable(movable);
+            } else if (prop == "data") {
+                if (Client *client = obj->extraData<Client*>())
+                    client->setData(value);
+            } else if (prop == "hideMode") {
+                Client::HideMode mode;
+                if (!toHideMode(value, &mode))
+                    return instance()->throwException<Value>("Client.hideMode needs to be \"default\", \"unmap\" or \"park\"");
+                if (Client *client = obj->extraData<Client*>())
+                    client->setHideMode(mode);
             } else if (prop == "backgroundColor") {
                 const Color color = readValue<Color>(value, ok, UndefinedValue);
                 if (!ok)
@@ -261,7 +304,7 @@ bool JavaScript::init(String *err)
                 return Class::ReadOnly|Class::DontDelete;
             }
 
-            if (prop == "backgroundColor" || prop == "text" || prop == "movable") {
+            if (prop == "backgroundColor" || prop == "text" || prop == "movable" || prop == "data") {
                 return Class::DontDelete;
             }
             return Value();
@@ -274,7 +317,7 @@ bool JavaScript::init(String *err)
         []() -> Value {
             return List<Value>() << "title" << "class" << "instance" << "dialog"
                                  << "window" << "focused" << "backgroundColor" << "text"
-                                 << "focusable" << "screen" << "rect" << "workspace" << "movable";
+                                 << "focusable" << "screen" << "rect" << "workspace" << "movable" << "data";
         });
 
     mClientClass->registerConstructor([](const List<Value> &args) -> Value {
@@ -327,7 +370,7 @@ bool JavaScript::init(String *err)
                 client->focus();
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -336,7 +379,7 @@ bool JavaScript::init(String *err)
                 client->raise();
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -345,7 +388,7 @@ bool JavaScript::init(String *err)
                 client->focus();
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -354,7 +397,7 @@ bool JavaScript::init(String *err)
                 client->close();
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -380,7 +423,7 @@ bool JavaScript::init(String *err)
                 client->move(Point(x, y));
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -397,7 +440,7 @@ bool JavaScript::init(String *err)
                 client->resize(Size(w, h));
                 WindowManager *wm = WindowManager::instance();
                 assert(wm);
-                xcb_flush(wm->connection());
+                wm->scheduleFlush();
             }
             return Value::undefined();
         });
@@ -519,13 +562,31 @@ bool JavaScript::init(String *err)
             if (!isFunction(func)) {
                 return instance()->throwException<Value>("First argument to nwm.on needs to be a function");
             }
-            mOns[name.toString()] = func;
+            if (mStaging) {
+                mPendingOns.append({ name.toString(), func, mEvaluating });
+            } else {
+                mOns[name.toString()] = func;
+                mOnFiles[name.toString()] = mEvaluating;
+            }
             return Value::undefined();
         });
     nwm->registerFunction("restart", [](const Object::SharedPtr&, const List<Value>&) -> Value {
             WindowManager::instance()->restart();
             return Value::undefined();
         });
+    nwm->registerFunction("softRestart", [](const Object::SharedPtr&, const List<Value>&) -> Value {
+            // not from inside the config we're about to tear down
+            EventLoop::eventLoop()->callLater([]() {
+                    String err;
+                    if (!WindowManager::instance()->softRestart(&err))
+                        error() << "Soft restart failed:" << err;
+                });
+            return Value::undefined();
+        });
+    nwm->registerFunction("upgrade", [](const Object::SharedPtr&, const List<Value>&) -> Value {
+            WindowManager::instance()->upgrade();
+            return Value::undefined();
+        });
     nwm->registerFunction("quit", [](const Object::SharedPtr&, const List<Value>& args) -> Value {
             if (args.size() > 1 || (args.size() == 1 && !args.first().isInteger()))
                 return instance()->throwException<Value>("Invalid arguments to nwm.quit(). Needs to 0 or 1 int argument");
@@ -565,6 +626,76 @@ bool JavaScript::init(String *err)
                               return ret;
                           });
 
+    nwm->registerProperty("flushStats",
+                          [](const Object::SharedPtr&) -> Value {
+                              const WindowManager::FlushStats &stats = WindowManager::instance()->flushStats();
+                              Value value;
+                              value["scheduled"] = stats.scheduled;
+                              value["coalesced"] = stats.coalesced;
+                              value["flushes"] = stats.flushes;
+                              return value;
+                          });
+
+    nwm->registerProperty("switchStats",
+                          [](const Object::SharedPtr&) -> Value {
+                              const WindowManager::SwitchStats &stats = WindowManager::instance()->switchStats();
+                              Value value;
+                              value["switches"] = stats.switches;
+                              value["lastUs"] = static_cast<double>(stats.last);
+                              value["maxUs"] = static_cast<double>(stats.max);
+                              value["averageUs"] = stats.switches ? static_cast<double>(stats.total) / stats.switches : 0.;
+                              return value;
+                          });
+
+    nwm->registerProperty("poolStats",
+                          [](const Object::SharedPtr&) -> Value {
+                              auto toValue = [](const PoolStats &stats) {
+                                  Value value;
+                                  value["live"] = stats.live;
+                                  value["peak"] = stats.peak;
+                                  value["allocations"] = stats.allocations;
+                                  value["slabs"] = stats.slabs;
+                                  return value;
+                              };
+                              Value value;
+                              value["clients"] = toValue(Client::poolStats());
+                              value["groups"] = toValue(ClientGroup::poolStats());
+                              value["graphics"] = toValue(Graphics::poolStats());
+                              return value;
+                          });
+
+    nwm->registerProperty("errorStats",
+                          [](const Object::SharedPtr&) -> Value {
+                              const Hash<uint16_t, int> &counts = WindowManager::instance()->errors().counts();
+                              List<Value> ret;
+                              ret.reserve(counts.size());
+                              for (const auto &count : counts) {
+                                  Value value;
+                                  value["request"] = static_cast<int>(Errors::majorCode(count.first));
+                                  value["error"] = static_cast<int>(Errors::errorCode(count.first));
+                                  value["count"] = count.second;
+                                  ret.append(value);
+                              }
+                              return ret;
+                          });
+
+    nwm->registerProperty("auditRoundTrips",
+                          [](const Object::SharedPtr&) -> Value {
+                              return RoundTrips::isEnabled();
+                          },
+                          [](const Object::SharedPtr&, const Value &value) {
+                              if (value.type() != Value::Type_Boolean) {
+                                  return instance()->throwException<void>("auditRoundTrips needs to be a boolean");
+                              }
+                              if (value.toBool() && !RoundTrips::isEnabled())
+                                  RoundTrips::reset();
+                              RoundTrips::setEnabled(value.toBool());
+                          });
+    nwm->registerProperty("roundTrips",
+                          [](const Object::SharedPtr&) -> Value {
+                              return RoundTrips::toValue();
+                          });
+
     nwm->registerProperty("focusedClient",
                           [](const Object::SharedPtr&) -> Value {
                               auto client = WindowManager::instance()->focusedClient();
@@ -727,7 +858,104 @@ bool JavaScript::init(String *err)
             if (ws < 0 || ws >= wss.size())
                 return instance()->throwException<Value>("Invalid workspace");
             wss[ws]->activate();
-            xcb_ewmh_set_current_desktop(wm->ewmhConnection(), wss[ws]->screenNumber(), ws);
+            return Value::undefined();
+        });
+    // switch under a server grab so that no frame shows half of it
+    workspace->registerProperty("grabOnSwitch",
+                                [](const Object::SharedPtr&) -> Value {
+                                    return WindowManager::instance()->grabOnSwitch();
+                                },
+                                [](const Object::SharedPtr&, const Value &value) {
+                                    if (value.type() != Value::Type_Boolean) {
+                                        return instance()->throwException<void>("workspace.grabOnSwitch needs to be a boolean");
+                                    }
+                                    WindowManager::instance()->setGrabOnSwitch(value.toBool());
+                                });
+    workspace->registerFunction("client", [](const Object::SharedPtr&, const List<Value> &args) -> Value {
+            // the nth most recently focused client on the active workspace
+            if (args.isEmpty() || args.size() > 2 || !args[0].isInteger())
+                return instance()->throwException<Value>("workspace.client takes an index and an optional screen");
+            WindowManager* wm = WindowManager::instance();
+            const int screenNumber = args.size() == 2 ? args[1].toInteger() : wm->currentScreen();
+            if (screenNumber < 0 || screenNumber >= wm->screenCount())
+                return instance()->throwException<Value>("workspace.client invalid screen number");
+            Workspace *active = wm->activeWorkspace(screenNumber);
+            Client *client = active ? active->client(args[0].toInteger()) : 0;
+            return client ? client->jsValue() : Value::undefined();
+        });
+    workspace->registerFunction("setLayout", [](const Object::SharedPtr&, const List<Value> &args) -> Value {
+            // { mode: "script"|"masterStack"|"grid"|"monocle"|"bsp", ratio, gap, masterCount }
+            if (args.size() < 2 || args.size() > 3 || !args[0].isInteger() || !args[1].isMap())
+                return instance()->throwException<Value>("workspace.setLayout takes a workspace, an object and an optional screen");
+            WindowManager* wm = WindowManager::instance();
+            const int screenNumber = args.size() == 3 ? args[2].toInteger() : wm->currentScreen();
+            if (screenNumber < 0 || screenNumber >= wm->screenCount())
+                return instance()->throwException<Value>("workspace.setLayout invalid screen number");
+            const List<Workspace*> &wss = wm->workspaces(screenNumber);
+            const int ws = args[0].toInteger();
+            if (ws < 0 || ws >= wss.size())
+                return instance()->throwException<Value>("Invalid workspace");
+
+            const Value &params = args[1];
+            bool ok;
+            LayoutEngine::Mode mode;
+            const String modeName = readChild<String>(params, "mode", ok, NotRequired,
+                                                      LayoutEngine::modeToString(wss[ws]->layoutEngine().mode()));
+            if (!ok || !LayoutEngine::modeFromString(modeName, &mode))
+                return instance()->throwException<Value>("workspace.setLayout unknown mode");
+            const double ratio = readChild<double>(params, "ratio", ok, NotRequired, wss[ws]->layoutEngine().ratio());
+            if (!ok)
+                return instance()->throwException<Value>("workspace.setLayout ratio needs to be a number");
+            const int gap = readChild<int>(params, "gap", ok, NotRequired, wss[ws]->layoutEngine().gap());
+            if (!ok)
+                return instance()->throwException<Value>("workspace.setLayout gap needs to be an integer");
+            const int masterCount = readChild<int>(params, "masterCount", ok, NotRequired, wss[ws]->layoutEngine().masterCount());
+            if (!ok)
+                return instance()->throwException<Value>("workspace.setLayout masterCount needs to be an integer");
+
+            LayoutEngine &engine = wss[ws]->layoutEngine();
+            engine.setMode(mode);
+            engine.setRatio(ratio);
+            engine.setGap(gap);
+            engine.setMasterCount(masterCount);
+            wss[ws]->invalidateLayout();
+            return Value::undefined();
+        });
+    workspace->registerFunction("layout", [](const Object::SharedPtr&, const List<Value> &args) -> Value {
+            if (args.isEmpty() || args.size() > 2 || !args[0].isInteger())
+                return instance()->throwException<Value>("workspace.layout takes a workspace and an optional screen");
+            WindowManager* wm = WindowManager::instance();
+            const int screenNumber = args.size() == 2 ? args[1].toInteger() : wm->currentScreen();
+            if (screenNumber < 0 || screenNumber >= wm->screenCount())
+                return instance()->throwException<Value>("workspace.layout invalid screen number");
+            const List<Workspace*> &wss = wm->workspaces(screenNumber);
+            const int ws = args[0].toInteger();
+            if (ws < 0 || ws >= wss.size())
+                return instance()->throwException<Value>("Invalid workspace");
+            const LayoutEngine &engine = wss[ws]->layoutEngine();
+            Value ret;
+            ret["mode"] = LayoutEngine::modeToString(engine.mode());
+            ret["ratio"] = engine.ratio();
+            ret["gap"] = engine.gap();
+            ret["masterCount"] = engine.masterCount();
+            return ret;
+        });
+    workspace->registerFunction("setHideMode", [](const Object::SharedPtr&, const List<Value> &args) -> Value {
+            // how the clients of a workspace that isn't shown are hidden
+            if (args.size() < 2 || args.size() > 3 || !args[0].isInteger())
+                return instance()->throwException<Value>("workspace.setHideMode takes a workspace, a mode and an optional screen");
+            Client::HideMode mode;
+            if (!toHideMode(args[1], &mode))
+                return instance()->throwException<Value>("workspace.setHideMode mode needs to be \"unmap\" or \"park\"");
+            WindowManager* wm = WindowManager::instance();
+            const int screenNumber = args.size() == 3 ? args[2].toInteger() : wm->currentScreen();
+            if (screenNumber < 0 || screenNumber >= wm->screenCount())
+                return instance()->throwException<Value>("workspace.setHideMode invalid screen number");
+            const List<Workspace*> &wss = wm->workspaces(screenNumber);
+            const int ws = args[0].toInteger();
+            if (ws < 0 || ws >= wss.size())
+                return instance()->throwException<Value>("Invalid workspace");
+            wss[ws]->setHideMode(mode);
             return Value::undefined();
         });
     workspace->registerFunction("raiseLast", [](const Object::SharedPtr&, const List<Value>&) -> Value {
@@ -756,10 +984,15 @@ bool JavaScript::init(String *err)
             if (!binding.isValid())
                 return instance()->throwException<Value>(String::format<64>("Couldn't parse keybind for %s",
                                                                             key.toString().constData()));
-            WindowManager::instance()->bindings().add(binding);
+            if (mStaging) {
+                mPendingBindings.append({ binding, Set<Keybinding>(), mEvaluating });
+            } else {
+                WindowManager::instance()->bindings().add(binding);
+                mBindingFiles[binding] = mEvaluating;
+            }
             return Value::undefined();
         });
-    kbd->registerFunction("mode", [](const Object::SharedPtr&, const List<Value> &args) -> Value {
+    kbd->registerFunction("mode", [this](const Object::SharedPtr&, const List<Value> &args) -> Value {
             if (args.size() != 2)
                 return instance()->throwException<Value>("Invalid number of arguments to kbd.mode, 2 required");
             const Value &key = args.at(0);
@@ -788,30 +1021,21 @@ bool JavaScript::init(String *err)
             if (subbindings.isEmpty())
                 return instance()->throwException<Value>("Need at least one keybinding in the array for kbd.mode");
             Keybinding toggle(key.toString());
-            WindowManager::instance()->bindings().toggle(toggle, subbindings);
+            if (mStaging) {
+                mPendingBindings.append({ toggle, subbindings, mEvaluating });
+            } else {
+                WindowManager::instance()->bindings().toggle(toggle, subbindings);
+                mBindingFiles[toggle] = mEvaluating;
+            }
             return Value::undefined();
         });
-
-    for (int i=mJsFiles.size() - 1; i>=0; --i) {
-        const String contents = mJsFiles[i].readAll();
-        if (!contents.isEmpty()) {
-            String e;
-            evaluate(contents, mJsFiles[i], &e);
-            if (!e.isEmpty()) {
-                if (err)
-                    *err = e;
-                return false;
-            }
-        }
-    }
-    return true;
 }
 
 JavaScript::~JavaScript()
 {
     if (auto eventLoop = EventLoop::eventLoop()) {
-        for (int id : mActiveTimers) {
-            eventLoop->unregisterTimer(id);
+        for (const auto &timer : mActiveTimers) {
+            eventLoop->unregisterTimer(timer.first);
         }
     }
 }
@@ -848,15 +1072,156 @@ void JavaScript::onClientEvent(Client *client, const String &event)
     func->call({ client->jsValue() });
 }
 
-bool JavaScript::reload(String *err)
+static inline uint64_t contentHash(const String &contents)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    const char *data = contents.constData();
+    for (int i = 0; i < contents.size(); ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool JavaScript::reload(String *err, ReloadMode mode)
+{
+    EventLoop::SharedPtr eventLoop = EventLoop::eventLoop();
+    if (mode == Full) {
+        // the old config's timers would call into functions that are gone
+        if (eventLoop) {
+            for (const auto &timer : mActiveTimers) {
+                eventLoop->unregisterTimer(timer.first);
+            }
+        }
+        mActiveTimers.clear();
+        mFileHashes.clear();
+        mOnFiles.clear();
+        mBindingFiles.clear();
+        mOns.clear();
+        // the client wrappers stay, the clients are announced again
+        mClients.clear();
+    }
+
+    struct Changed {
+        Path file;
+        String contents;
+        uint64_t hash;
+    };
+    List<Changed> changed;
+    Set<Path> files;
+    for (int i=mJsFiles.size() - 1; i>=0; --i) {
+        const Path &file = mJsFiles.at(i);
+        const String contents = file.readAll();
+        const uint64_t hash = contentHash(contents);
+        const auto it = mFileHashes.find(file);
+        if (it != mFileHashes.end() && it->second == hash)
+            continue;
+        changed.append({ file, contents, hash });
+        files.insert(file);
+    }
+    if (changed.isEmpty())
+        return true;
+
+    Set<int> previousTimers;
+    for (const auto &timer : mActiveTimers) {
+        if (files.contains(timer.second))
+            previousTimers.insert(timer.first);
+    }
+
+    // only a file that was loaded before has something to fall back on. A
+    // new one, which is all of them for a Full reload, registers right away
+    // so that windows it creates while it loads see its handlers
+    String e;
+    Set<Path> staged;
+    for (const Changed &entry : changed) {
+        mStaging = mFileHashes.contains(entry.file);
+        // a file that's been emptied or removed registers nothing, which
+        // drops what it registered before
+        if (mStaging)
+            staged.insert(entry.file);
+        if (entry.contents.isEmpty())
+            continue;
+        mEvaluating = entry.file;
+        evaluate(entry.contents, entry.file, &e);
+        if (!e.isEmpty())
+            break;
+    }
+    mEvaluating.clear();
+    mStaging = false;
+
+    // the changed files' old timers if they evaluated, otherwise the ones
+    // they started before failing
+    const bool ok = e.isEmpty();
+    List<int> stale;
+    for (const auto &timer : mActiveTimers) {
+        if (files.contains(timer.second) && previousTimers.contains(timer.first) == ok)
+            stale.append(timer.first);
+    }
+    for (int id : stale) {
+        if (eventLoop)
+            eventLoop->unregisterTimer(id);
+        mActiveTimers.remove(id);
+    }
+
+    if (!ok) {
+        // whatever was registered before stays in effect
+        mPendingOns.clear();
+        mPendingBindings.clear();
+        if (err)
+            *err = e;
+        return false;
+    }
+    commit(staged);
+    for (const Changed &entry : changed)
+        mFileHashes[entry.file] = entry.hash;
+    return true;
+}
+
+void JavaScript::commit(const Set<Path> &files)
 {
-    for (const auto &client : mClients) {
-        client->clearJSValue();
+    Set<String> ons;
+    for (const PendingOn &on : mPendingOns)
+        ons.insert(on.name);
+    Set<Keybinding> bindings;
+    for (const PendingBinding &pending : mPendingBindings)
+        bindings.insert(pending.binding);
+
+    // drop what the evaluated files registered last time and didn't this time
+    for (auto it = mOnFiles.begin(); it != mOnFiles.end(); ) {
+        if (files.contains(it->second) && !ons.contains(it->first)) {
+            mOns.remove(it->first);
+            it = mOnFiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    Keybindings &keybindings = WindowManager::instance()->bindings();
+    for (auto it = mBindingFiles.begin(); it != mBindingFiles.end(); ) {
+        if (files.contains(it->second) && !bindings.contains(it->first)) {
+            keybindings.remove(it->first);
+            it = mBindingFiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // the new ones replace the old, bindings for keys that were bound already
+    // aren't grabbed again
+    for (const PendingOn &on : mPendingOns) {
+        mOns[on.name] = on.func;
+        mOnFiles[on.name] = on.file;
+    }
+    for (const PendingBinding &pending : mPendingBindings) {
+        if (pending.subbindings.isEmpty()) {
+            keybindings.add(pending.binding);
+        } else {
+            keybindings.toggle(pending.binding, pending.subbindings);
+        }
+        mBindingFiles[pending.binding] = pending.file;
     }
-    mClients.clear();
-    mOns.clear();
-    mClientClass.reset();
-    return init(err);
+    mPendingOns.clear();
+    mPendingBindings.clear();
 }
 
 Value JavaScript::startTimer(const List<Value> &args, unsigned int flags)
@@ -868,16 +1233,21 @@ Value JavaScript::startTimer(const List<Value> &args, unsigned int flags)
     if (interval < 0)
         return instance()->throwException<Value>("Invalid arguments to setTimeout/setInterval");
     std::shared_ptr<ScriptEngine::Object> func = toObject(args[0]);
-    return EventLoop::eventLoop()->registerTimer([this, func](int id) {
+    const int id = EventLoop::eventLoop()->registerTimer([this, func, flags](int id) {
+            if (flags & Timer::SingleShot)
+                mActiveTimers.remove(id);
             assert(func->isFunction());
             func->call();
         }, interval, flags);
+    mActiveTimers[id] = mEvaluating;
+    return id;
 }
 
 Value JavaScript::clearTimer(const List<Value> &args)
 {
     if (args.size() != 1 || args.first().type() != Value::Type_Integer)
         return instance()->throwException<Value>("Invalid arguments to setTimeout");
+    mActiveTimers.remove(args.first().toInteger());
     EventLoop::eventLoop()->unregisterTimer(args.first().toInteger());
     return Value::undefined();
 }
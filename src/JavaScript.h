@@ -2,11 +2,14 @@
 #define JAVASCRIPT_H
 
 #include "Client.h"
+#include "Keybinding.h"
 #include <rct/rct-config.h>
 #include <rct/ScriptEngine.h>
 #include <rct/String.h>
 #include <rct/Value.h>
 #include <rct/Hash.h>
+#include <rct/Map.h>
+#include <rct/Set.h>
 #include <rct/Timer.h>
 
 class JavaScript : public ScriptEngine
@@ -16,8 +19,16 @@ public:
     ~JavaScript();
 
     List<Path> jsFiles() const { return mJsFiles; }
-    bool init(const List<Path> &jsFiles, String *err = 0) { mJsFiles = jsFiles; return init(err); }
-    bool reload(String *error = 0);
+    bool init(const List<Path> &jsFiles, String *err = 0)
+    {
+        mJsFiles = jsFiles;
+        setup();
+        return reload(err, Full);
+    }
+    // Incremental only evaluates the files that changed since they were last
+    // loaded, replacing what those files registered. Full starts over.
+    enum ReloadMode { Incremental, Full };
+    bool reload(String *error = 0, ReloadMode mode = Incremental);
     Value evaluateFile(const Path &path, String *error);
 
     std::shared_ptr<Class> clientClass() const { return mClientClass; }
@@ -39,9 +50,33 @@ private:
     Value startTimer(const List<Value> &args, unsigned int flags);
     Value clearTimer(const List<Value> &args);
 
-    Set<int> mActiveTimers;
-    bool init(String *error);
+    void setup();
+    void commit(const Set<Path> &files);
+
+    // nwm.on and nwm.kbd calls made while evaluating files that were loaded
+    // before are held back until all of them evaluated cleanly
+    struct PendingBinding {
+        Keybinding binding;
+        Set<Keybinding> subbindings; // for kbd.mode
+        Path file;
+    };
+    struct PendingOn {
+        String name;
+        Value func;
+        Path file;
+    };
+
+    Hash<int, Path> mActiveTimers; // id to the file that started it, if any
     List<Path> mJsFiles;
+    Hash<Path, uint64_t> mFileHashes; // contents when last evaluated
+    // which file registered a handler or binding, those go away when the file
+    // is evaluated again without registering them
+    Hash<String, Path> mOnFiles;
+    Map<Keybinding, Path> mBindingFiles;
+    Path mEvaluating;
+    bool mStaging;
+    List<PendingBinding> mPendingBindings;
+    List<PendingOn> mPendingOns;
     std::shared_ptr<Class> mClientClass, mFileClass;
     Hash<String, Value> mOns;
     List<Client*> mClients;
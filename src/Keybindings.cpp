@@ -26,7 +26,7 @@ bool Keybindings::feed(xkb_keysym_t sym, uint16_t mods)
         for (xcb_window_t root : roots) {
             xcb_grab_keyboard_cookie_t cookie = xcb_grab_keyboard(conn, 1, root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
             xcb_generic_error_t* err = 0;
-            AutoPointer<xcb_grab_keyboard_reply_t> reply(xcb_grab_keyboard_reply(conn, cookie, &err));
+            AutoPointer<xcb_grab_keyboard_reply_t> reply(ROUND_TRIP(xcb_grab_keyboard_reply(conn, cookie, &err)));
 
             assert(!err);
         }
@@ -122,13 +122,29 @@ const Keybinding* Keybindings::current()
     return &*it;
 }
 
+static inline bool sameKeys(const Keybinding &a, const Keybinding &b)
+{
+    return !(a < b) && !(b < a);
+}
+
 void Keybindings::add(const Keybinding& binding)
 {
     WindowManager *wm = WindowManager::instance();
     xcb_connection_t* conn = wm->connection();
 
+    // mCurrentToggle points at the binding we're about to replace
+    const bool wasCurrent = mCurrentToggle && sameKeys(*mCurrentToggle, binding);
+    if (wasCurrent)
+        mCurrentToggle = 0;
+    mToggles.remove(binding);
+    const bool existed = mKeybindings.remove(binding);
     mKeybindings.insert(binding);
-    if (mCurrentToggle)
+    if (wasCurrent) {
+        rebindAll();
+        return;
+    }
+    // the keys are grabbed already
+    if (mCurrentToggle || existed)
         return;
     for (xcb_window_t root : wm->roots())
         rebind(binding, conn, root);
@@ -137,6 +153,48 @@ void Keybindings::add(const Keybinding& binding)
     }
 }
 
+void Keybindings::remove(const Keybinding& binding)
+{
+    WindowManager *wm = WindowManager::instance();
+    xcb_connection_t* conn = wm->connection();
+
+    const bool wasCurrent = mCurrentToggle && sameKeys(*mCurrentToggle, binding);
+    if (wasCurrent)
+        mCurrentToggle = 0;
+    mToggles.remove(binding);
+    if (!mKeybindings.remove(binding))
+        return;
+    if (wasCurrent) {
+        rebindAll();
+        return;
+    }
+    // leaving the current toggle rebinds everything anyway
+    if (mCurrentToggle)
+        return;
+
+    const auto &seqs = binding.sequence();
+    if (seqs.isEmpty())
+        return;
+    const auto &seq = seqs.front();
+    // keep the grab if another binding starts with the same keys
+    for (const Keybinding &other : mKeybindings) {
+        if (other.sequence().isEmpty())
+            continue;
+        const Keybinding::Sequence &front = other.sequence().front();
+        if (!(front < seq) && !(seq < front))
+            return;
+    }
+    mPrefixes.remove(seq);
+    for (xcb_window_t root : wm->roots()) {
+        for (xcb_keycode_t code : seq.codes)
+            xcb_ungrab_key(conn, code, root, seq.mods);
+    }
+    for (auto it : Client::clients()) {
+        for (xcb_keycode_t code : seq.codes)
+            xcb_ungrab_key(conn, code, it.first, seq.mods);
+    }
+}
+
 void Keybindings::toggle(const Keybinding &binding, const Set<Keybinding> &subbindings)
 {
     if (!mEscape.isValid()) {
@@ -149,6 +207,20 @@ void Keybindings::toggle(const Keybinding &binding, const Set<Keybinding> &subbi
     mToggles[binding].insert(mEscape);
 }
 
+void Keybindings::clear()
+{
+    if (mGrabbed) {
+        mGrabbed = false;
+        xcb_ungrab_keyboard(WindowManager::instance()->connection(), XCB_CURRENT_TIME);
+    }
+    mFeed.mSeq.clear();
+    mCurrentToggle = 0;
+    mToggles.clear();
+    mKeybindings.clear();
+    // with nothing left to bind this only ungrabs
+    rebindAll();
+}
+
 void Keybindings::rebindAll()
 {
     mPrefixes.clear();
@@ -16,11 +16,15 @@ public:
     bool feed(xkb_keysym_t sym, uint16_t mods);
     const Keybinding* current();
 
+    // replaces any binding for the same keys
     void add(const Keybinding& binding);
+    void remove(const Keybinding& binding);
     void toggle(const Keybinding& binding, const Set<Keybinding>& subbindings);
 
     void rebindAll();
     void rebind(xcb_window_t win);
+    // forgets every binding and releases the key grabs
+    void clear();
 
 private:
     void rebind(const Keybinding& binding, xcb_connection_t* conn, xcb_window_t win);
@@ -0,0 +1,179 @@
+#include "LayoutEngine.h"
+#include "Client.h"
+#include <algorithm>
+#include <math.h>
+
+LayoutEngine::LayoutEngine()
+    : mMode(Script), mRatio(0.55), mGap(0), mMasterCount(1)
+{
+}
+
+void LayoutEngine::setRatio(double ratio)
+{
+    mRatio = std::min(std::max(ratio, 0.1), 0.9);
+}
+
+static const struct {
+    LayoutEngine::Mode mode;
+    const char *name;
+} sModes[] = {
+    { LayoutEngine::Script, "script" },
+    { LayoutEngine::MasterStack, "masterStack" },
+    { LayoutEngine::Grid, "grid" },
+    { LayoutEngine::Monocle, "monocle" },
+    { LayoutEngine::Bsp, "bsp" }
+};
+
+bool LayoutEngine::modeFromString(const String &name, Mode *mode)
+{
+    for (const auto &entry : sModes) {
+        if (name == entry.name) {
+            *mode = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *LayoutEngine::modeToString(Mode mode)
+{
+    for (const auto &entry : sModes) {
+        if (entry.mode == mode)
+            return entry.name;
+    }
+    return "script";
+}
+
+Size LayoutEngine::constrain(const xcb_size_hints_t &hints, const Size &size)
+{
+    int width = size.width;
+    int height = size.height;
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_RESIZE_INC) {
+        // ICCCM: the base size falls back to the minimum size
+        int baseWidth = 0, baseHeight = 0;
+        if (hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE) {
+            baseWidth = hints.base_width;
+            baseHeight = hints.base_height;
+        } else if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
+            baseWidth = hints.min_width;
+            baseHeight = hints.min_height;
+        }
+        if (hints.width_inc > 1 && width > baseWidth)
+            width = baseWidth + ((width - baseWidth) / hints.width_inc) * hints.width_inc;
+        if (hints.height_inc > 1 && height > baseHeight)
+            height = baseHeight + ((height - baseHeight) / hints.height_inc) * hints.height_inc;
+    }
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MAX_SIZE) {
+        if (hints.max_width > 0)
+            width = std::min(width, hints.max_width);
+        if (hints.max_height > 0)
+            height = std::min(height, hints.max_height);
+    }
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
+        width = std::max(width, hints.min_width);
+        height = std::max(height, hints.min_height);
+    }
+    return Size(std::max(width, 1), std::max(height, 1));
+}
+
+static inline void split(const Rect &area, int count, bool horizontal, List<Rect> *rects)
+{
+    // the last one gets what rounding leaves over
+    int offset = 0;
+    const int total = horizontal ? area.width : area.height;
+    for (int i = 0; i < count; ++i) {
+        const int size = i == count - 1 ? total - offset : total / count;
+        if (horizontal) {
+            rects->append(Rect(area.x + offset, area.y, size, area.height));
+        } else {
+            rects->append(Rect(area.x, area.y + offset, area.width, size));
+        }
+        offset += size;
+    }
+}
+
+void LayoutEngine::tile(const Rect &area, int count, List<Rect> *rects) const
+{
+    switch (mMode) {
+    case Script:
+        break;
+    case Monocle:
+        for (int i = 0; i < count; ++i)
+            rects->append(area);
+        break;
+    case MasterStack: {
+        const int masters = std::min(mMasterCount, count);
+        if (masters == count) {
+            split(area, count, false, rects);
+            break;
+        }
+        const int masterWidth = static_cast<int>(area.width * mRatio);
+        split(Rect(area.x, area.y, masterWidth, area.height), masters, false, rects);
+        split(Rect(area.x + masterWidth, area.y, area.width - masterWidth, area.height), count - masters, false, rects);
+        break; }
+    case Grid: {
+        const int columns = static_cast<int>(ceil(sqrt(static_cast<double>(count))));
+        const int rows = (count + columns - 1) / columns;
+        List<Rect> rowRects;
+        split(area, rows, false, &rowRects);
+        // a short last row spreads out over the whole width
+        for (int row = 0; row < rows; ++row)
+            split(rowRects.at(row), std::min(columns, count - row * columns), true, rects);
+        break; }
+    case Bsp: {
+        // each client takes its share of what's left, alternating between
+        // splitting left/right and top/bottom
+        Rect rest = area;
+        for (int i = 0; i < count; ++i) {
+            if (i == count - 1) {
+                rects->append(rest);
+                break;
+            }
+            if (i % 2 == 0) {
+                const int width = static_cast<int>(rest.width * mRatio);
+                rects->append(Rect(rest.x, rest.y, width, rest.height));
+                rest.x += width;
+                rest.width -= width;
+            } else {
+                const int height = static_cast<int>(rest.height * mRatio);
+                rects->append(Rect(rest.x, rest.y, rest.width, height));
+                rest.y += height;
+                rest.height -= height;
+            }
+        }
+        break; }
+    }
+}
+
+void LayoutEngine::apply(const Rect &area, const List<Client*> &clients) const
+{
+    List<Client*> tiled;
+    tiled.reserve(clients.size());
+    for (Client *client : clients) {
+        if (!client->isMovable()) {
+            tiled.append(client);
+            continue;
+        }
+        if (client->hasUserSpecifiedPosition())
+            continue;
+        const Rect rect = client->rect();
+        client->setRect(Rect(area.x + (area.width - rect.width) / 2, area.y + (area.height - rect.height) / 2,
+                             rect.width, rect.height));
+    }
+    if (tiled.isEmpty())
+        return;
+
+    // half a gap around the area and half around every cell makes a full gap
+    // everywhere
+    const int half = mGap / 2;
+    const Rect inner(area.x + half, area.y + half, area.width - 2 * half, area.height - 2 * half);
+    List<Rect> rects;
+    rects.reserve(tiled.size());
+    tile(inner, tiled.size(), &rects);
+    for (int i = 0; i < rects.size(); ++i) {
+        const Rect &cell = rects.at(i);
+        const Size size = constrain(tiled.at(i)->normalHints(),
+                                    Size(std::max(cell.width - 2 * half, 1), std::max(cell.height - 2 * half, 1)));
+        tiled.at(i)->setRect(Rect(cell.x + half, cell.y + half, size.width, size.height));
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef LAYOUTENGINE_H
+#define LAYOUTENGINE_H
+
+#include "Rect.h"
+#include <rct/List.h>
+#include <rct/String.h>
+#include <xcb/xcb_icccm.h>
+
+class Client;
+
+// Tiles the clients of a workspace natively, all of them in one pass. JS
+// only picks the mode and its parameters; in Script mode the JS layout
+// handler is called per client instead, like before there was an engine.
+class LayoutEngine
+{
+public:
+    enum Mode {
+        Script,
+        MasterStack,
+        Grid,
+        Monocle,
+        Bsp
+    };
+
+    LayoutEngine();
+
+    Mode mode() const { return mMode; }
+    void setMode(Mode mode) { mMode = mode; }
+    bool isNative() const { return mMode != Script; }
+
+    // share of the area the master column (or the first half of a bsp
+    // split) gets, 0.1 to 0.9
+    double ratio() const { return mRatio; }
+    void setRatio(double ratio);
+    // pixels between clients and around the edge
+    int gap() const { return mGap; }
+    void setGap(int gap) { mGap = gap < 0 ? 0 : gap; }
+    int masterCount() const { return mMasterCount; }
+    void setMasterCount(int count) { mMasterCount = count < 1 ? 1 : count; }
+
+    static bool modeFromString(const String &name, Mode *mode);
+    static const char *modeToString(Mode mode);
+
+    // tiles the clients over area in order. Floating ones keep their size
+    // and are centered unless they asked for a position, the caller leaves
+    // out the ones that were placed already
+    void apply(const Rect &area, const List<Client*> &clients) const;
+
+    // the largest size within size that the hints allow
+    static Size constrain(const xcb_size_hints_t &hints, const Size &size);
+
+private:
+    void tile(const Rect &area, int count, List<Rect> *rects) const;
+
+    Mode mMode;
+    double mRatio;
+    int mGap;
+    int mMasterCount;
+};
+
+#endif
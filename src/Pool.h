@@ -0,0 +1,87 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <rct/List.h>
+#include <new>
+#include <type_traits>
+#include <stdlib.h>
+
+struct PoolStats {
+    PoolStats()
+        : live(0), peak(0), allocations(0), slabs(0)
+    {}
+
+    int live, peak, allocations, slabs;
+};
+
+// Hands out blocks for objects of type T from slabs of SlabSize blocks and
+// keeps released blocks on a free list for the next allocation, so that
+// windows coming and going don't turn into a malloc/free pair per object.
+// Classes hook it up through their own operator new and operator delete.
+template <typename T, int SlabSize = 64>
+class Pool
+{
+public:
+    Pool()
+        : mFree(0)
+    {}
+    ~Pool()
+    {
+        // whatever is still alive at exit keeps its memory
+        if (!mStats.live) {
+            for (Node *slab : mSlabs)
+                free(slab);
+        }
+    }
+
+    void *allocate()
+    {
+        if (!mFree)
+            grow();
+        Node *node = mFree;
+        mFree = node->next;
+        ++mStats.allocations;
+        if (++mStats.live > mStats.peak)
+            mStats.peak = mStats.live;
+        return node;
+    }
+
+    void release(void *ptr)
+    {
+        if (!ptr)
+            return;
+        Node *node = static_cast<Node*>(ptr);
+        node->next = mFree;
+        mFree = node;
+        --mStats.live;
+    }
+
+    const PoolStats& stats() const { return mStats; }
+    static int blockSize() { return sizeof(Node); }
+    static int slabSize() { return SlabSize; }
+
+private:
+    union Node {
+        Node *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    void grow()
+    {
+        Node *slab = static_cast<Node*>(malloc(sizeof(Node) * SlabSize));
+        if (!slab)
+            throw std::bad_alloc();
+        mSlabs.append(slab);
+        ++mStats.slabs;
+        for (int i = SlabSize - 1; i >= 0; --i) {
+            slab[i].next = mFree;
+            mFree = slab + i;
+        }
+    }
+
+    Node *mFree;
+    List<Node*> mSlabs;
+    PoolStats mStats;
+};
+
+#endif
@@ -35,6 +35,12 @@ public:
     Point point() const { return Point({ x, y }); }
     Size size() const { return Size({ width, height }); }
     bool isEmpty() const { return !width || !height; }
+
+    bool operator==(const Rect &other) const
+    {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+    bool operator!=(const Rect &other) const { return !(*this == other); }
 };
 
 inline Log operator<<(Log stream, const Size& size)
@@ -0,0 +1,59 @@
+#include "Replies.h"
+#include <xcb/xcbext.h>
+#include <assert.h>
+#include <stdlib.h>
+
+Replies::Replies()
+    : mConn(0)
+{
+}
+
+Replies::~Replies()
+{
+    clear();
+}
+
+void Replies::add(unsigned int sequence, const Continuation &continuation)
+{
+    assert(continuation);
+    // requests are nearly always added in the order they were sent, but a
+    // continuation can wait on a request that went out before one queued
+    // further up
+    auto it = mEntries.end();
+    while (it != mEntries.begin()) {
+        auto prev = it;
+        --prev;
+        if (static_cast<int>(sequence - prev->sequence) >= 0)
+            break;
+        it = prev;
+    }
+    mEntries.insert(it, Entry({ sequence, continuation }));
+}
+
+int Replies::process()
+{
+    int count = 0;
+    while (!mEntries.isEmpty()) {
+        void *reply = 0;
+        xcb_generic_error_t *error = 0;
+        if (!xcb_poll_for_reply(mConn, mEntries.front().sequence, &reply, &error))
+            break;
+        // the continuation may add more entries
+        const Continuation continuation = mEntries.front().continuation;
+        mEntries.removeFirst();
+        continuation(reply, error);
+        if (reply)
+            free(reply);
+        if (error)
+            free(error);
+        ++count;
+    }
+    return count;
+}
+
+void Replies::clear()
+{
+    // only called when the connection is going away, the replies are
+    // discarded along with it
+    mEntries.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef REPLIES_H
+#define REPLIES_H
+
+#include <rct/LinkedList.h>
+#include <xcb/xcb.h>
+#include <functional>
+
+// Runs continuations for outstanding requests once their replies have been
+// read off the connection, so that handlers don't have to block on a round
+// trip. Entries are kept in sequence order; since the server answers in that
+// order, processing stops at the first reply that hasn't arrived yet.
+//
+// The reply passed to a continuation is null if the request failed, both
+// the reply and the error are freed once the continuation returns.
+class Replies
+{
+public:
+    typedef std::function<void(void *reply, xcb_generic_error_t *error)> Continuation;
+
+    Replies();
+    ~Replies();
+
+    void setConnection(xcb_connection_t *conn) { mConn = conn; }
+
+    void add(unsigned int sequence, const Continuation &continuation);
+
+    template <typename Reply, typename Cookie>
+    void wait(Cookie cookie, const std::function<void(Reply *reply, xcb_generic_error_t *error)> &continuation)
+    {
+        add(cookie.sequence, [continuation](void *reply, xcb_generic_error_t *error) {
+                continuation(static_cast<Reply *>(reply), error);
+            });
+    }
+
+    // returns the number of continuations that ran
+    int process();
+    void clear();
+
+    bool isEmpty() const { return mEntries.isEmpty(); }
+    int pending() const { return mEntries.size(); }
+
+private:
+    struct Entry {
+        unsigned int sequence;
+        Continuation continuation;
+    };
+    xcb_connection_t *mConn;
+    LinkedList<Entry> mEntries;
+};
+
+#endif
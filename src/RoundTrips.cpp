@@ -0,0 +1,122 @@
+#include "RoundTrips.h"
+#include <rct/List.h>
+#include <algorithm>
+#include <time.h>
+
+bool RoundTrips::sEnabled = false;
+const char *RoundTrips::sHandler = 0;
+void (*RoundTrips::sWaitHook)() = 0;
+Hash<String, RoundTrips::Stats> RoundTrips::sSites;
+Hash<String, RoundTrips::Stats> RoundTrips::sHandlers;
+
+static const char *noHandler = "(no handler)";
+
+uint64_t RoundTrips::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void RoundTrips::setEnabled(bool enabled)
+{
+    sEnabled = enabled;
+}
+
+void RoundTrips::reset()
+{
+    sSites.clear();
+    sHandlers.clear();
+}
+
+void RoundTrips::enter(const char *handler)
+{
+    ++sHandlers[handler ? handler : noHandler].count;
+}
+
+void RoundTrips::record(const char *function, int line, uint64_t elapsed)
+{
+    Stats &site = sSites[String::format<128>("%s:%d", function, line)];
+    ++site.count;
+    ++site.roundTrips;
+    site.elapsed += elapsed;
+    site.max = std::max(site.max, elapsed);
+
+    Stats &handler = sHandlers[sHandler ? sHandler : noHandler];
+    ++handler.roundTrips;
+    handler.elapsed += elapsed;
+    handler.max = std::max(handler.max, elapsed);
+}
+
+typedef std::pair<String, RoundTrips::Stats> Entry;
+
+static inline double perEvent(const Entry &entry)
+{
+    // round trips outside of event handlers don't have events to divide by
+    return entry.second.count ? static_cast<double>(entry.second.roundTrips) / entry.second.count : entry.second.roundTrips;
+}
+
+static inline List<Entry> sorted(const Hash<String, RoundTrips::Stats> &hash, bool (*lessThan)(const Entry &, const Entry &))
+{
+    List<Entry> ret;
+    ret.reserve(hash.size());
+    for (const auto &it : hash)
+        ret.append(it);
+    std::sort(ret.begin(), ret.end(), lessThan);
+    return ret;
+}
+
+static bool byRoundTripsPerEvent(const Entry &a, const Entry &b)
+{
+    return perEvent(a) > perEvent(b);
+}
+
+static bool byElapsed(const Entry &a, const Entry &b)
+{
+    return a.second.elapsed > b.second.elapsed;
+}
+
+String RoundTrips::report()
+{
+    if (!sEnabled && sSites.isEmpty())
+        return "Round trip auditing is disabled";
+
+    String ret = "Handlers (round trips per event, events, round trips, total ms, max ms):\n";
+    for (const Entry &entry : sorted(sHandlers, byRoundTripsPerEvent)) {
+        ret += String::format<256>("  %-24s %8.2f %8d %8d %10.2f %8.2f\n", entry.first.constData(),
+                                   perEvent(entry), entry.second.count, entry.second.roundTrips,
+                                   entry.second.elapsed / 1000., entry.second.max / 1000.);
+    }
+    ret += "Call sites (round trips, total ms, max ms):\n";
+    for (const Entry &entry : sorted(sSites, byElapsed)) {
+        ret += String::format<256>("  %-40s %8d %10.2f %8.2f\n", entry.first.constData(),
+                                   entry.second.roundTrips, entry.second.elapsed / 1000., entry.second.max / 1000.);
+    }
+    return ret;
+}
+
+static inline Value toValue(const Entry &entry, bool handler)
+{
+    Value value;
+    value[handler ? "handler" : "site"] = entry.first;
+    if (handler)
+        value["events"] = entry.second.count;
+    value["roundTrips"] = entry.second.roundTrips;
+    value["totalMs"] = entry.second.elapsed / 1000.;
+    value["maxMs"] = entry.second.max / 1000.;
+    return value;
+}
+
+Value RoundTrips::toValue()
+{
+    List<Value> handlers, sites;
+    for (const Entry &entry : sorted(sHandlers, byRoundTripsPerEvent))
+        handlers.append(::toValue(entry, true));
+    for (const Entry &entry : sorted(sSites, byElapsed))
+        sites.append(::toValue(entry, false));
+    Value value;
+    value["enabled"] = sEnabled;
+    value["handlers"] = handlers;
+    value["sites"] = sites;
+    return value;
+}
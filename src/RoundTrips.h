@@ -0,0 +1,92 @@
+#ifndef ROUNDTRIPS_H
+#define ROUNDTRIPS_H
+
+#include <rct/Hash.h>
+#include <rct/String.h>
+#include <rct/Value.h>
+#include <stdint.h>
+
+// Audits blocking calls on the X connection. Every call that waits for the
+// server is wrapped in ROUND_TRIP() which, while auditing is enabled, records
+// the calling site, the time spent waiting and the event handler that was
+// running at the time. Disabled it costs a branch per round trip.
+class RoundTrips
+{
+public:
+    static bool isEnabled() { return sEnabled; }
+    static void setEnabled(bool enabled);
+    static void reset();
+
+    // called after every blocking call, audited or not
+    static void setWaitHook(void (*hook)()) { sWaitHook = hook; }
+
+    struct Stats {
+        Stats()
+            : count(0), roundTrips(0), elapsed(0), max(0)
+        {}
+
+        int count; // calls for a site, events for a handler
+        int roundTrips;
+        uint64_t elapsed, max;
+    };
+
+    static String report();
+    static Value toValue();
+
+    static uint64_t now(); // monotonic, us
+
+    class Scope
+    {
+    public:
+        Scope(const char *function, int line)
+            : mFunction(function), mLine(line), mStart(sEnabled ? now() : 0)
+        {
+        }
+        ~Scope()
+        {
+            if (mStart)
+                record(mFunction, mLine, now() - mStart);
+            if (sWaitHook)
+                sWaitHook();
+        }
+
+    private:
+        const char *mFunction;
+        const int mLine;
+        const uint64_t mStart;
+    };
+
+    // marks the event handler that round trips are attributed to
+    class Handler
+    {
+    public:
+        Handler(const char *name)
+            : mPrevious(sHandler)
+        {
+            sHandler = name;
+            if (sEnabled)
+                enter(name);
+        }
+        ~Handler()
+        {
+            sHandler = mPrevious;
+        }
+
+    private:
+        const char *mPrevious;
+    };
+
+private:
+    static void record(const char *function, int line, uint64_t elapsed);
+    static void enter(const char *handler);
+
+    static bool sEnabled;
+    static const char *sHandler;
+    static void (*sWaitHook)();
+    static Hash<String, Stats> sSites;
+    static Hash<String, Stats> sHandlers;
+};
+
+#define ROUND_TRIP(call) (RoundTrips::Scope(__FUNCTION__, __LINE__), (call))
+
+#endif
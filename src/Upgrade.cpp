@@ -0,0 +1,151 @@
+#include "Upgrade.h"
+#include <rct/Log.h>
+#include <rct/Serializer.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// bump whenever the layout changes
+enum { Magic = 0x6e776d55, Version = 3 };
+static const char *const EnvironmentVariable = "NWM_UPGRADE_FD";
+
+inline Serializer &operator<<(Serializer &s, const Rect &rect)
+{
+    s << rect.x << rect.y << rect.width << rect.height;
+    return s;
+}
+
+inline Deserializer &operator>>(Deserializer &s, Rect &rect)
+{
+    s >> rect.x >> rect.y >> rect.width >> rect.height;
+    return s;
+}
+
+inline Serializer &operator<<(Serializer &s, const xcb_size_hints_t &hints)
+{
+    s << hints.flags << hints.x << hints.y << hints.width << hints.height
+      << hints.min_width << hints.min_height << hints.max_width << hints.max_height
+      << hints.width_inc << hints.height_inc << hints.min_aspect_num << hints.min_aspect_den
+      << hints.max_aspect_num << hints.max_aspect_den << hints.base_width << hints.base_height
+      << hints.win_gravity;
+    return s;
+}
+
+inline Deserializer &operator>>(Deserializer &s, xcb_size_hints_t &hints)
+{
+    s >> hints.flags >> hints.x >> hints.y >> hints.width >> hints.height
+      >> hints.min_width >> hints.min_height >> hints.max_width >> hints.max_height
+      >> hints.width_inc >> hints.height_inc >> hints.min_aspect_num >> hints.min_aspect_den
+      >> hints.max_aspect_num >> hints.max_aspect_den >> hints.base_width >> hints.base_height
+      >> hints.win_gravity;
+    return s;
+}
+
+inline Serializer &operator<<(Serializer &s, const Upgrade::ClientState &state)
+{
+    s << state.window << state.leader << state.transientFor << state.windowType
+      << state.sizeHints << state.screen << state.workspace << state.rect << state.noFocus << state.movable
+      << state.className << state.instanceName << state.windowTypes << state.ewmhState << state.data;
+    return s;
+}
+
+inline Deserializer &operator>>(Deserializer &s, Upgrade::ClientState &state)
+{
+    s >> state.window >> state.leader >> state.transientFor >> state.windowType
+      >> state.sizeHints >> state.screen >> state.workspace >> state.rect >> state.noFocus >> state.movable
+      >> state.className >> state.instanceName >> state.windowTypes >> state.ewmhState >> state.data;
+    return s;
+}
+
+inline Serializer &operator<<(Serializer &s, const Upgrade::ScreenState &state)
+{
+    s << state.rect << state.activeWorkspace << state.focusStacks;
+    return s;
+}
+
+inline Deserializer &operator>>(Deserializer &s, Upgrade::ScreenState &state)
+{
+    s >> state.rect >> state.activeWorkspace >> state.focusStacks;
+    return s;
+}
+
+Upgrade::Upgrade()
+    : focused(XCB_NONE)
+{
+}
+
+bool Upgrade::publish(String *error) const
+{
+    String data;
+    {
+        Serializer serializer(data);
+        serializer << static_cast<int>(Magic) << static_cast<int>(Version) << clients << screens << focused;
+    }
+
+    // no MFD_CLOEXEC, the next binary reads it
+    const int fd = memfd_create("nwm-upgrade", 0);
+    if (fd == -1) {
+        *error = String::format<128>("memfd_create failed: %s", strerror(errno));
+        return false;
+    }
+    const char *ptr = data.constData();
+    int remaining = data.size();
+    while (remaining > 0) {
+        const ssize_t written = ::write(fd, ptr, remaining);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            *error = String::format<128>("Unable to write upgrade state: %s", strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        ptr += written;
+        remaining -= written;
+    }
+    setenv(EnvironmentVariable, String::number(fd).constData(), 1);
+    return true;
+}
+
+bool Upgrade::take()
+{
+    const char *value = getenv(EnvironmentVariable);
+    if (!value)
+        return false;
+    // unsetenv() frees what getenv() returned
+    const String env = value;
+    bool ok;
+    const int fd = env.toLong(&ok);
+    // don't hand it down to whatever we spawn, or to the next restart
+    unsetenv(EnvironmentVariable);
+    if (!ok || fd < 0) {
+        error() << "Invalid" << EnvironmentVariable << env;
+        return false;
+    }
+
+    String data;
+    char buf[16384];
+    off_t offset = 0;
+    for (;;) {
+        const ssize_t r = ::pread(fd, buf, sizeof(buf), offset);
+        if (r == -1 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        data.append(buf, r);
+        offset += r;
+    }
+    ::close(fd);
+
+    Deserializer deserializer(data.constData(), data.size());
+    int magic = 0, version = 0;
+    deserializer >> magic >> version;
+    if (magic != Magic || version != Version) {
+        error() << "Upgrade state has version" << version << "expected" << Version
+                << "- adopting windows from scratch";
+        return false;
+    }
+    deserializer >> clients >> screens >> focused;
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef UPGRADE_H
+#define UPGRADE_H
+
+#include "Rect.h"
+#include <rct/List.h>
+#include <rct/String.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_icccm.h>
+#include <string.h>
+
+// What one nwm binary hands to the next across execve() for a live upgrade,
+// see WindowManager::upgrade(). The state is serialized into a memfd that
+// survives the exec and whose number is passed in NWM_UPGRADE_FD.
+//
+// The windows themselves come back through the save set when the old
+// connection goes away, the new binary adopts them with the state recorded
+// here instead of asking the server and laying them out again.
+class Upgrade
+{
+public:
+    Upgrade();
+
+    struct ClientState {
+        ClientState()
+            : window(XCB_NONE), leader(XCB_NONE), transientFor(XCB_NONE),
+              windowType(XCB_NONE), screen(0), workspace(-1),
+              noFocus(false), movable(false)
+        {
+            memset(&sizeHints, '\0', sizeof(sizeHints));
+        }
+
+        xcb_window_t window, leader, transientFor, windowType;
+        xcb_size_hints_t sizeHints; // WM_NORMAL_HINTS
+        int screen;
+        int workspace; // -1 when sticky
+        Rect rect;
+        bool noFocus, movable;
+        String className, instanceName;
+        List<xcb_atom_t> windowTypes, ewmhState;
+        String data; // Client.data from the JS side, as JSON
+    };
+
+    struct ScreenState {
+        ScreenState()
+            : activeWorkspace(0)
+        {}
+
+        Rect rect;
+        int activeWorkspace;
+        // per workspace, most recently focused first
+        List<List<xcb_window_t> > focusStacks;
+    };
+
+    List<ClientState> clients;
+    List<ScreenState> screens;
+    xcb_window_t focused;
+
+    // writes the state and points NWM_UPGRADE_FD at it, the descriptor stays
+    // open for the exec
+    bool publish(String *error) const;
+    // reads what publish() left behind and forgets about it, returns false
+    // if we weren't started by an upgrade or can't read the state
+    bool take();
+};
+
+#endif
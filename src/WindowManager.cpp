@@ -1,6 +1,8 @@
 #include "WindowManager.h"
+#include "AtomSet.h"
 #include "Atoms.h"
 #include "Client.h"
+#include "EventBatch.h"
 #include "Handlers.h"
 #include "Types.h"
 #include <rct/EventLoop.h>
@@ -44,7 +46,7 @@ typedef union {
     xcb_xkb_state_notify_event_t state_notify;
 } _xkb_event;
 
-static inline void handleXkb(_xkb_event* event)
+static void handleXkb(const _xkb_event* event)
 {
     WindowManager *wm = WindowManager::instance();
     if (event->any.deviceID == wm->xkbDevice()) {
@@ -71,7 +73,10 @@ public:
     enum Flag {
         Restart = 0x01,
         Reload = 0x02,
-        Quit = 0x04
+        Quit = 0x04,
+        RoundTrips = 0x08,
+        Upgrade = 0x10,
+        SoftRestart = 0x20
     };
 
     List<String> scripts() const { return mScripts; }
@@ -92,9 +97,11 @@ private:
 WindowManager *WindowManager::sInstance;
 
 WindowManager::WindowManager()
-    : mConn(0), mEwmhConn(0), mPreferredScreenIndex(0), mXkbEvent(0), mSyms(0), mTimestamp(XCB_CURRENT_TIME),
+    : mConn(0), mEwmhConn(0), mPreferredScreenIndex(0), mXkbEvent(0), mSyms(0), mEventsScheduled(false), mUseReaderThread(false),
+      mFlushPending(false), mFlushQueued(false), mGrabOnSwitch(false), mSwitchStart(0),
+      mTimestamp(XCB_CURRENT_TIME),
       mMoveModifierMask(0), mMoving(0), mFocused(0), mFocusPolicy(FocusFollowsMouse),
-      mCurrentScreen(-1), mConnectionFd(-1), mExitCode(0), mRestart(false)
+      mCurrentScreen(-1), mConnectionFd(-1), mExitCode(0), mRestart(false), mUpgrade(false)
 {
     Message::registerMessage<NWMMessage>();
     memset(&mXkb, '\0', sizeof(mXkb));
@@ -119,8 +126,13 @@ static inline void usage(FILE *out)
             "  -t|--connect-timeout [ms]           Max time to wait for connection\n"
             "  -r|--reload                         Reload config files\n"
             "  -R|--restart                        Restart window manager\n"
+            "  -U|--upgrade                        Restart into a new build of the window manager, keeping its state\n"
+            "  -k|--soft-restart                   Rerun the config without letting go of the windows\n"
             "  -q|--quit [optional status code]    Stop window manager\n"
-            "  -n|--no-user-config                 Don't load ~/.config/nwm.js\n");
+            "  -n|--no-user-config                 Don't load ~/.config/nwm.js\n"
+            "  -A|--audit-round-trips              Record blocking round trips to the X server\n"
+            "  -a|--round-trips                    Report round trips recorded with --audit-round-trips\n"
+            "  -T|--reader-thread                  Read X events on a separate thread\n");
 }
 
 bool WindowManager::init(int &argc, char **argv)
@@ -152,7 +164,12 @@ bool WindowManager::init(int &argc, char **argv)
         { "quit", optional_argument, 0, 'q' },
         { "reload", no_argument, 0, 'r' },
         { "restart", no_argument, 0, 'R' },
+        { "upgrade", no_argument, 0, 'U' },
+        { "soft-restart", no_argument, 0, 'k' },
         { "connect-timeout", required_argument, 0, 't' },
+        { "audit-round-trips", no_argument, 0, 'A' },
+        { "round-trips", no_argument, 0, 'a' },
+        { "reader-thread", no_argument, 0, 'T' },
         { 0, no_argument, 0, 0 }
     };
 
@@ -227,6 +244,21 @@ bool WindowManager::init(int &argc, char **argv)
         case 'R':
             flags |= NWMMessage::Restart;
             break;
+        case 'U':
+            flags |= NWMMessage::Upgrade;
+            break;
+        case 'k':
+            flags |= NWMMessage::SoftRestart;
+            break;
+        case 'A':
+            RoundTrips::setEnabled(true);
+            break;
+        case 'a':
+            flags |= NWMMessage::RoundTrips;
+            break;
+        case 'T':
+            mUseReaderThread = true;
+            break;
         case 'n':
             userConfig = false;
             break;
@@ -264,6 +296,7 @@ bool WindowManager::init(int &argc, char **argv)
         fprintf(stderr, "Can't initialize logging\n");
         return false;
     }
+    registerHandlers();
 
     if (userConfig)
         jsFiles << Path::home() + ".config/nwm.js";
@@ -287,6 +320,7 @@ bool WindowManager::init(int &argc, char **argv)
     if (!mConn || xcb_connection_has_error(mConn)) {
         return false;
     }
+    mReplies.setConnection(mConn);
     const xcb_setup_t *setup = xcb_get_setup(mConn);
     if (setup) {
         warning() << "status" << static_cast<uint32_t>(setup->status) << '\n'
@@ -317,6 +351,7 @@ bool WindowManager::init(int &argc, char **argv)
     for (int i=0; i<screenCount; ++i) {
         mScreens[i].screen = it.data;
         mScreens[i].visual = xcb_aux_get_visualtype(mConn, i, it.data->root_visual);
+        mWindows.insert(it.data->root, WindowRegistry::RootWindow, 0, i);
         xcb_screen_next(&it);
     }
     mEwmhConn = new xcb_ewmh_connection_t;
@@ -329,7 +364,7 @@ bool WindowManager::init(int &argc, char **argv)
         mEwmhConn = 0;
         return false;
     }
-    if (!xcb_ewmh_init_atoms_replies(mEwmhConn, ewmhCookies, 0)) {
+    if (!ROUND_TRIP(xcb_ewmh_init_atoms_replies(mEwmhConn, ewmhCookies, 0))) {
         error() << "unable to get ewmh reply";
         xcb_disconnect(mConn);
         mConn = 0;
@@ -377,13 +412,17 @@ bool WindowManager::init(int &argc, char **argv)
             }
             mScreens[i].workspaces.first()->activate();
             xcb_ewmh_set_number_of_desktops(mEwmhConn, i, mScreens.at(i).workspaces.size());
-            xcb_ewmh_set_current_desktop(mEwmhConn, i, 0);
         }
 
-        if (!manage()) {
+        // set if the previous binary exec'ed us for an upgrade
+        Upgrade previous;
+        const bool upgrading = previous.take();
+        if (!manage(upgrading ? &previous : 0)) {
             error() << "Unable to manage existing windows";
             return false;
         }
+        if (upgrading)
+            restore(previous);
         for (const auto &script : scripts) {
             String err;
             mJS.evaluate(script, "<message>", &err);
@@ -407,16 +446,29 @@ bool WindowManager::init(int &argc, char **argv)
                                 restart();
                             }
 
+                            if (m->flags() & NWMMessage::Upgrade) {
+                                upgrade();
+                            }
+
                             if (m->flags() & NWMMessage::Quit) {
                                 quit(m->exitCode());
                             }
 
                             String err;
+                            if (m->flags() & NWMMessage::SoftRestart && !softRestart(&err)) {
+                                // the windows are all still there, keep going
+                                c->write<128>("Soft restart failed, error in init file(s): %s", err.constData());
+                            }
+
                             if (m->flags() & NWMMessage::Reload && !mJS.reload(&err)) {
                                 c->write<128>("Error in init file(s): %s", err.constData());
                                 EventLoop::eventLoop()->quit();
                             }
 
+                            if (m->flags() & NWMMessage::RoundTrips) {
+                                c->write(RoundTrips::report());
+                            }
+
                             for (const auto &script : m->scripts()) {
                                 String error;
                                 const Value ret = mJS.evaluate(script, "<message>", &error);
@@ -473,6 +525,7 @@ bool WindowManager::init(int &argc, char **argv)
 WindowManager::~WindowManager()
 {
     Client::clear();
+    mWindows.clear();
     mJS.clear();
     for (Screen &screen : mScreens) {
         screen.workspaces.deleteAll();
@@ -487,10 +540,15 @@ WindowManager::~WindowManager()
         xcb_key_symbols_free(mSyms);
 
     if (mConn) {
+        mReplies.clear();
         if (EventLoop::SharedPtr eventLoop = EventLoop::eventLoop()) {
-            const int fd = xcb_get_file_descriptor(mConn);
+            const int fd = mReader.isRunning() ? mReader.fd() : xcb_get_file_descriptor(mConn);
             eventLoop->unregisterSocket(fd);
         }
+        if (mReader.isRunning()) {
+            RoundTrips::setWaitHook(0);
+            mReader.stop();
+        }
 
         if (mEwmhConn) {
             xcb_ewmh_connection_wipe(mEwmhConn);
@@ -507,14 +565,15 @@ WindowManager::~WindowManager()
     sInstance = 0;
 }
 
-bool WindowManager::manage()
+bool WindowManager::manage(const Upgrade *upgrade)
 {
-    // Manage all existing windows
+    // Manage all existing windows, they're adopted in one go at the end
+    List<std::pair<xcb_window_t, int> > adoptees;
     int screenNumber = 0;
     for (const auto &it : mScreens) {
         AutoPointer<xcb_generic_error_t> err;
         xcb_query_tree_cookie_t treeCookie = xcb_query_tree(mConn, it.screen->root);
-        AutoPointer<xcb_query_tree_reply_t> treeReply(xcb_query_tree_reply(mConn, treeCookie, &err));
+        AutoPointer<xcb_query_tree_reply_t> treeReply(ROUND_TRIP(xcb_query_tree_reply(mConn, treeCookie, &err)));
         if (err) {
             LOG_ERROR(err, "Unable to query window tree");
             return false;
@@ -536,8 +595,8 @@ bool WindowManager::manage()
             }
             for (int i = 0; i < clientLength; ++i) {
                 AutoPointer<xcb_generic_error_t> err;
-                AutoPointer<xcb_get_window_attributes_reply_t> attr(xcb_get_window_attributes_reply(mConn, attrs[i], &err));
-                xcb_get_property_reply_t* state = xcb_get_property_reply(mConn, states[i], 0);
+                AutoPointer<xcb_get_window_attributes_reply_t> attr(ROUND_TRIP(xcb_get_window_attributes_reply(mConn, attrs[i], &err)));
+                xcb_get_property_reply_t* state = ROUND_TRIP(xcb_get_property_reply(mConn, states[i], 0));
                 if (err) {
                     LOG_ERROR(err, "Unable to get attrs");
                 }
@@ -552,18 +611,91 @@ bool WindowManager::manage()
                     || stateValue == XCB_ICCCM_WM_STATE_WITHDRAWN) {
                     continue;
                 }
-                Client *client = Client::manage(clients[i], screenNumber);
-                (void)client;
+                adoptees.append(std::make_pair(clients[i], screenNumber));
             }
         }
         ++screenNumber;
     }
+    Client::adopt(adoptees, upgrade);
     return true;
 }
 
+void WindowManager::upgrade()
+{
+    Upgrade state;
+    // the config creates its own windows again
+    for (const auto &it : Client::clients()) {
+        if (it.second->isOwned())
+            continue;
+        Upgrade::ClientState client;
+        it.second->snapshot(&client);
+        state.clients.append(client);
+    }
+    for (const Screen &screen : mScreens) {
+        Upgrade::ScreenState ss;
+        ss.rect = screen.rect;
+        ss.activeWorkspace = screen.workspaces.indexOf(screen.activeWorkspace);
+        for (Workspace *ws : screen.workspaces) {
+            List<xcb_window_t> stack;
+            for (Client *client : ws->clients()) {
+                if (!client->isOwned())
+                    stack.append(client->window());
+            }
+            ss.focusStacks.append(stack);
+        }
+        state.screens.append(ss);
+    }
+    if (mFocused && !mFocused->isOwned())
+        state.focused = mFocused->window();
+
+    String err;
+    if (!state.publish(&err)) {
+        error() << "Unable to upgrade:" << err;
+        return;
+    }
+    warning() << "upgrading with" << state.clients.size() << "clients";
+    // main() does the exec once we've let go of the X connection, the
+    // windows come back to the root through the save set in the meantime
+    mUpgrade = true;
+    EventLoop::eventLoop()->quit();
+}
+
+void WindowManager::restore(const Upgrade &upgrade)
+{
+    const int count = std::min(mScreens.size(), upgrade.screens.size());
+    for (int i = 0; i < count; ++i) {
+        const Upgrade::ScreenState &ss = upgrade.screens.at(i);
+        Screen &screen = mScreens[i];
+        setRect(ss.rect, i);
+        // put the focus order back, oldest first so the most recent ends up in front
+        const int workspaceCount = std::min(screen.workspaces.size(), ss.focusStacks.size());
+        for (int w = 0; w < workspaceCount; ++w) {
+            Workspace *ws = screen.workspaces.at(w);
+            const List<xcb_window_t> &stack = ss.focusStacks.at(w);
+            for (auto it = stack.crbegin(); it != stack.crend(); ++it) {
+                Client *client = Client::client(*it);
+                if (client && client->workspace() == ws)
+                    ws->updateFocus(client);
+            }
+        }
+        if (ss.activeWorkspace >= 0 && ss.activeWorkspace < screen.workspaces.size())
+            screen.workspaces.at(ss.activeWorkspace)->activate();
+        // activate() only hides the workspace that was shown before
+        for (Workspace *ws : screen.workspaces) {
+            if (ws != screen.activeWorkspace)
+                ws->deactivate();
+        }
+    }
+    if (Client *client = Client::client(upgrade.focused))
+        client->focus();
+    warning() << "restored" << upgrade.clients.size() << "clients from upgrade";
+}
+
 bool WindowManager::install()
 {
     Atoms::setup(mConn);
+    Atoms::setup(mEwmhConn);
+    AtomSet::setup(mEwmhConn);
 
     xcb_void_cookie_t cookie;
     AutoPointer<xcb_generic_error_t> err;
@@ -572,7 +704,7 @@ bool WindowManager::install()
     {
         const uint32_t values[] = { XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT };
         cookie = xcb_change_window_attributes_checked(mConn, mScreens.at(mPreferredScreenIndex).screen->root, XCB_CW_EVENT_MASK, values);
-        err = xcb_request_check(mConn, cookie);
+        err = ROUND_TRIP(xcb_request_check(mConn, cookie));
         if (err) {
             LOG_ERROR(err, "Unable to change window attributes 1");
             return false;
@@ -641,7 +773,7 @@ bool WindowManager::install()
                                                                  0,
                                                                  XCB_XKB_EVENT_TYPE_STATE_NOTIFY | XCB_XKB_EVENT_TYPE_MAP_NOTIFY,
                                                                  affectMap, map, 0);
-        err = xcb_request_check(mConn, select);
+        err = ROUND_TRIP(xcb_request_check(mConn, select));
         if (err) {
             LOG_ERROR(err, "Unable to select XKB events");
             xkb_state_unref(state);
@@ -651,6 +783,7 @@ bool WindowManager::install()
         }
 
         mXkbEvent = reply->first_event;
+        mDispatcher.setHandler(mXkbEvent, "xkb event", &EventDispatcher::handler<_xkb_event, handleXkb>);
         mXkb = Xkb({ ctx, keymap, state, deviceId });
 
         mSyms = xcb_key_symbols_alloc(mConn);
@@ -709,7 +842,7 @@ bool WindowManager::install()
     for (Screen &s : mScreens) {
         s.rect = { 0, 0, s.screen->width_in_pixels, s.screen->height_in_pixels };
         cookie = xcb_change_window_attributes_checked(mConn, s.screen->root, XCB_CW_EVENT_MASK, values);
-        err = xcb_request_check(mConn, cookie);
+        err = ROUND_TRIP(xcb_request_check(mConn, cookie));
         if (err) {
             LOG_ERROR(err, "Unable to change window attributes 2");
             return false;
@@ -718,7 +851,7 @@ bool WindowManager::install()
         cookie = xcb_change_property(mConn, XCB_PROP_MODE_REPLACE,
                                      s.screen->root, mEwmhConn->_NET_SUPPORTED, XCB_ATOM_ATOM, 32,
                                      Rct::countof(atom), atom);
-        err = xcb_request_check(mConn, cookie);
+        err = ROUND_TRIP(xcb_request_check(mConn, cookie));
         if (err) {
             LOG_ERROR(err, "Unable to change _NET_SUPPORTED property on root window");
             return false;
@@ -726,14 +859,24 @@ bool WindowManager::install()
 
         xcb_ewmh_set_wm_pid(mEwmhConn, s.screen->root, getpid());
     }
-    xcb_flush(mConn);
+    flush();
 
     // Get events
     mConnectionFd = xcb_get_file_descriptor(mConn);
-    EventLoop::eventLoop()->registerSocket(mConnectionFd, EventLoop::SocketRead, [this](int, unsigned int) {
-            assert(WindowManager::instance());
-            processXCBEVents();
-        });
+    if (mUseReaderThread && mReader.start(mConn)) {
+        // waiting for a reply may have queued up events the reader can't see
+        RoundTrips::setWaitHook([]() { WindowManager::instance()->mReader.kick(); });
+        EventLoop::eventLoop()->registerSocket(mReader.fd(), EventLoop::SocketRead, [this](int, unsigned int) {
+                assert(WindowManager::instance());
+                mReader.acknowledge();
+                processXCBEVents();
+            });
+    } else {
+        EventLoop::eventLoop()->registerSocket(mConnectionFd, EventLoop::SocketRead, [this](int, unsigned int) {
+                assert(WindowManager::instance());
+                processXCBEVents();
+            });
+    }
 
     return true;
 }
@@ -742,7 +885,7 @@ bool WindowManager::isRunning()
 {
     xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_pid(mEwmhConn, mScreens.at(mPreferredScreenIndex).screen->root);
     uint32_t pid;
-    if (!xcb_ewmh_get_wm_pid_reply(mEwmhConn, cookie, &pid, 0))
+    if (!ROUND_TRIP(xcb_ewmh_get_wm_pid_reply(mEwmhConn, cookie, &pid, 0)))
         return false;
 
     return pid != static_cast<uint32_t>(getpid()) && !kill(pid, 0);
@@ -763,7 +906,7 @@ xkb_keysym_t WindowManager::keycodeToKeysym(xcb_keycode_t code)
     return xkb_state_key_get_one_sym(mXkb.state, code);
 }
 
-void WindowManager::updateXkbState(xcb_xkb_state_notify_event_t* state)
+void WindowManager::updateXkbState(const xcb_xkb_state_notify_event_t* state)
 {
     xkb_state_update_mask(mXkb.state,
                           state->baseMods,
@@ -774,7 +917,7 @@ void WindowManager::updateXkbState(xcb_xkb_state_notify_event_t* state)
                           state->lockedGroup);
 }
 
-void WindowManager::updateXkbMap(xcb_xkb_map_notify_event_t* map)
+void WindowManager::updateXkbMap(const xcb_xkb_map_notify_event_t* map)
 {
     assert(mSyms);
     xcb_key_symbols_free(mSyms);
@@ -800,10 +943,77 @@ void WindowManager::addWorkspace(int screenNumber)
             addWorkspace(i);
     } else {
         Screen &screen = mScreens[screenNumber];
+        if (screen.reusedWorkspaces != -1 && screen.reusedWorkspaces < screen.workspaces.size()) {
+            // soft restart, the config gets back what it had
+            ++screen.reusedWorkspaces;
+            return;
+        }
         screen.workspaces.append(new Workspace(screenNumber, screen.rect));
+        if (screen.reusedWorkspaces != -1)
+            ++screen.reusedWorkspaces;
     }
 }
 
+bool WindowManager::softRestart(String *err)
+{
+    // the config creates its own windows again
+    List<Client*> owned, managed;
+    for (const auto &it : Client::clients()) {
+        if (it.second->isOwned()) {
+            owned.append(it.second);
+        } else {
+            managed.append(it.second);
+        }
+    }
+    for (Client *client : owned)
+        client->close();
+    Client::reap();
+
+    mBindings.clear();
+    if (mMoving) {
+        // nothing would be left to end the move
+        stopMoving();
+        Handlers::releaseGrab(mConn, timestamp());
+    }
+
+    for (Screen &screen : mScreens)
+        screen.reusedWorkspaces = 0;
+    const bool ok = mJS.reload(err, JavaScript::Full);
+    for (int i = 0; i < mScreens.size(); ++i) {
+        Screen &screen = mScreens[i];
+        const int keep = std::max(screen.reusedWorkspaces, 1);
+        screen.reusedWorkspaces = -1;
+        // a config that failed part of the way through may not have gotten
+        // around to asking for its workspaces, they all stay
+        if (!ok || keep >= screen.workspaces.size())
+            continue;
+        // the config asked for fewer workspaces this time, the clients on the
+        // ones that go away end up on the last one left
+        Workspace *last = screen.workspaces.at(keep - 1);
+        const bool wasActive = screen.workspaces.indexOf(screen.activeWorkspace) >= keep;
+        if (wasActive)
+            activateWorkspace(last);
+        while (screen.workspaces.size() > keep) {
+            Workspace *ws = screen.workspaces.takeLast();
+            while (Client *client = ws->clients().first())
+                last->addClient(client);
+            delete ws;
+        }
+        if (wasActive)
+            last->activate();
+        xcb_ewmh_set_number_of_desktops(mEwmhConn, i, screen.workspaces.size());
+    }
+
+    // whatever the config got through before failing still applies
+    for (Client *client : managed)
+        mJS.onClient(client);
+    mBindings.rebindAll();
+    if (!ok)
+        return false;
+    warning() << "soft restarted with" << managed.size() << "clients";
+    return true;
+}
+
 void WindowManager::setMoveModifier(const String& mod)
 {
     mMoveModifier = mod;
@@ -820,17 +1030,6 @@ List<xcb_window_t> WindowManager::roots() const
     return roots;
 }
 
-int WindowManager::screenNumber(xcb_window_t root) const
-{
-    int screenNumber = 0;
-    for (const auto &it : mScreens) {
-        if (it.screen->root == root)
-            return screenNumber;
-        ++screenNumber;
-    }
-    return -1;
-}
-
 xcb_visualtype_t* WindowManager::visualForScreen(unsigned int screen) const
 {
     assert(screen < static_cast<unsigned int>(mScreens.size()));
@@ -868,7 +1067,7 @@ Point WindowManager::pointer(int *screen, bool *ok) const
 {
     xcb_query_pointer_cookie_t cookie = xcb_query_pointer(mConn, roots()[mCurrentScreen]);
     AutoPointer<xcb_generic_error_t> err;
-    xcb_query_pointer_reply_t *reply = xcb_query_pointer_reply(mConn, cookie, &err);
+    xcb_query_pointer_reply_t *reply = ROUND_TRIP(xcb_query_pointer_reply(mConn, cookie, &err));
     if (err) {
         LOG_ERROR(err, "Unable to query pointer");
         if (ok)
@@ -898,21 +1097,64 @@ bool WindowManager::warpPointer(const Point &point, int screen, PointerMode mode
         return false;
     }
 
-    xcb_void_cookie_t cookie = xcb_warp_pointer_checked(mConn, XCB_NONE, mScreens.at(screen).screen->root,
-                                                        0, 0, 0, 0, point.x, point.y);
-    AutoPointer<xcb_generic_error_t> err(xcb_request_check(mConn, cookie));
-    if (err) {
-        LOG_ERROR(err, "Unable to warp pointer");
-        return false;
-    }
-    xcb_flush(mConn);
+    const xcb_void_cookie_t cookie = xcb_warp_pointer(mConn, XCB_NONE, mScreens.at(screen).screen->root,
+                                                      0, 0, 0, 0, point.x, point.y);
+    mErrors.expect(cookie, [](const xcb_generic_error_t* err) {
+            LOG_ERROR(err, "Unable to warp pointer");
+        });
+    // the user is waiting on this one
+    flush();
 
     return true;
 }
 
+void WindowManager::registerHandlers()
+{
+#define HANDLER(type, name, event, func) mDispatcher.setHandler(type, name, &EventDispatcher::handler<event, func>)
+    HANDLER(XCB_BUTTON_PRESS, "button press", xcb_button_press_event_t, Handlers::handleButtonPress);
+    HANDLER(XCB_BUTTON_RELEASE, "button release", xcb_button_release_event_t, Handlers::handleButtonRelease);
+    HANDLER(XCB_MOTION_NOTIFY, "motion notify", xcb_motion_notify_event_t, Handlers::handleMotionNotify);
+    HANDLER(XCB_CLIENT_MESSAGE, "client message", xcb_client_message_event_t, Handlers::handleClientMessage);
+    HANDLER(XCB_CONFIGURE_REQUEST, "configure request", xcb_configure_request_event_t, Handlers::handleConfigureRequest);
+    HANDLER(XCB_CONFIGURE_NOTIFY, "configure notify", xcb_configure_notify_event_t, Handlers::handleConfigureNotify);
+    HANDLER(XCB_DESTROY_NOTIFY, "destroy notify", xcb_destroy_notify_event_t, Handlers::handleDestroyNotify);
+    HANDLER(XCB_ENTER_NOTIFY, "enter notify", xcb_enter_notify_event_t, Handlers::handleEnterNotify);
+    HANDLER(XCB_EXPOSE, "expose", xcb_expose_event_t, Handlers::handleExpose);
+    HANDLER(XCB_FOCUS_IN, "focus in", xcb_focus_in_event_t, Handlers::handleFocusIn);
+    HANDLER(XCB_KEY_PRESS, "key press", xcb_key_press_event_t, Handlers::handleKeyPress);
+    HANDLER(XCB_MAP_REQUEST, "map request", xcb_map_request_event_t, Handlers::handleMapRequest);
+    HANDLER(XCB_PROPERTY_NOTIFY, "property notify", xcb_property_notify_event_t, Handlers::handlePropertyNotify);
+    HANDLER(XCB_UNMAP_NOTIFY, "unmap notify", xcb_unmap_notify_event_t, Handlers::handleUnmapNotify);
+#undef HANDLER
+    // extension events are registered in install() once their base is known
+
+    mDispatcher.updateTrace();
+}
+
+EventBatch::Priority WindowManager::eventPriority(const xcb_generic_event_t *event) const
+{
+    const uint8_t type = event->response_type & ~0x80;
+    // keysyms are looked up through the xkb state, a key press mustn't get
+    // ahead of the group or modifier change that came before it
+    if (mXkbEvent && type == mXkbEvent)
+        return EventBatch::Input;
+    switch (type) {
+    case XCB_KEY_PRESS:
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE:
+        return EventBatch::Input;
+    case XCB_MOTION_NOTIFY:
+        // only worth jumping the queue while we're dragging a window around
+        return mMoving ? EventBatch::Input : EventBatch::Normal;
+    default:
+        break;
+    }
+    return EventBatch::Normal;
+}
+
 void WindowManager::processXCBEVents()
 {
-    List<xcb_generic_event_t*> events;
+    EventBatch &events = mEventBatch;
     for (;;) {
         if (xcb_connection_has_error(mConn)) {
             error() << "X server connection error" << xcb_connection_has_error(mConn);
@@ -920,95 +1162,111 @@ void WindowManager::processXCBEVents()
                 mRestart = true;
                 eventLoop->quit();
             }
-            events.deleteAll(&free);
+            events.clear();
+            mReplies.clear();
+            mErrors.clear();
             return;
         }
-        xcb_generic_event_t *event = xcb_poll_for_event(mConn);
+        xcb_generic_event_t *event = mReader.isRunning() ? mReader.take() : xcb_poll_for_event(mConn);
         if (!event)
             break;
-        const unsigned int responseType = event->response_type & ~0x80;
-        if (responseType == XCB_MOTION_NOTIFY || responseType == XCB_ENTER_NOTIFY) {
-            const int size = events.size();
-            for (int i=0; i<size; ++i) {
-                if ((events[i]->response_type & ~0x80) == responseType) {
-                    free(events[i]);
-                    events.removeAt(i);
-                    break;
-                }
-            }
+        if (!event->response_type) {
+            // errors go to their senders right away, they're not batched
+            mErrors.handle(reinterpret_cast<xcb_generic_error_t*>(event));
+            free(event);
+            continue;
         }
-        events.append(event);
+        mErrors.retire(event->full_sequence);
+        events.add(event, eventPriority(event));
     }
 
-    for (auto event : events) {
-        const auto responseType = event->response_type & ~0x80;
-        switch (responseType) {
-        case XCB_BUTTON_PRESS:
-            warning() << "button press";
-            Handlers::handleButtonPress(reinterpret_cast<xcb_button_press_event_t*>(event));
-            break;
-        case XCB_BUTTON_RELEASE:
-            warning() << "button release";
-            Handlers::handleButtonRelease(reinterpret_cast<xcb_button_release_event_t*>(event));
-            break;
-        case XCB_MOTION_NOTIFY:
-            warning() << "motion notify";
-            Handlers::handleMotionNotify(reinterpret_cast<xcb_motion_notify_event_t*>(event));
-            break;
-        case XCB_CLIENT_MESSAGE:
-            warning() << "client message";
-            Handlers::handleClientMessage(reinterpret_cast<xcb_client_message_event_t*>(event));
-            break;
-        case XCB_CONFIGURE_REQUEST:
-            warning() << "configure request";
-            Handlers::handleConfigureRequest(reinterpret_cast<xcb_configure_request_event_t*>(event));
-            break;
-        case XCB_CONFIGURE_NOTIFY:
-            warning() << "configure notify";
-            Handlers::handleConfigureNotify(reinterpret_cast<xcb_configure_notify_event_t*>(event));
-            break;
-        case XCB_DESTROY_NOTIFY:
-            warning() << "destroy notify";
-            Handlers::handleDestroyNotify(reinterpret_cast<xcb_destroy_notify_event_t*>(event));
-            break;
-        case XCB_ENTER_NOTIFY:
-            warning() << "enter notify";
-            Handlers::handleEnterNotify(reinterpret_cast<xcb_enter_notify_event_t*>(event));
-            break;
-        case XCB_EXPOSE:
-            warning() << "expose";
-            Handlers::handleExpose(reinterpret_cast<xcb_expose_event_t*>(event));
-            break;
-        case XCB_FOCUS_IN:
-            warning() << "focus in";
-            Handlers::handleFocusIn(reinterpret_cast<xcb_focus_in_event_t*>(event));
-            break;
-        case XCB_KEY_PRESS:
-            warning() << "key press";
-            Handlers::handleKeyPress(reinterpret_cast<xcb_key_press_event_t*>(event));
-            break;
-        case XCB_MAP_REQUEST:
-            warning() << "map request";
-            Handlers::handleMapRequest(reinterpret_cast<xcb_map_request_event_t*>(event));
-            break;
-        case XCB_PROPERTY_NOTIFY:
-            warning() << "property notify";
-            Handlers::handlePropertyNotify(reinterpret_cast<xcb_property_notify_event_t*>(event));
-            break;
-        case XCB_UNMAP_NOTIFY:
-            warning() << "unmap notify";
-            Handlers::handleUnmapNotify(reinterpret_cast<xcb_unmap_notify_event_t*>(event));
-            break;
-        default:
-            if (responseType == mXkbEvent) {
-                warning() << "xkb event";
-                handleXkb(reinterpret_cast<_xkb_event*>(event));
-                break;
-            }
-            warning() << "unhandled event" << responseType;
+    // replies read along with the events came in ahead of anything that
+    // hasn't been dispatched yet
+    mReplies.process();
+
+    // input goes first, no matter how much else is queued up behind it
+    while (const xcb_generic_event_t *event = events.takeInput()) {
+        mDispatcher.dispatch(event);
+    }
+
+    // everything else gets a time slice, the rest is picked up on the next
+    // loop iteration so that timers and the IPC socket get a chance to run
+    const uint64_t deadline = Rct::monoMs() + EventTimeSlice;
+    while (const xcb_generic_event_t *event = events.take()) {
+        mDispatcher.dispatch(event);
+        if (Rct::monoMs() >= deadline)
             break;
-        }
-        free(event);
     }
+
+    if (events.atEnd()) {
+        if (events.coalesced())
+            warning() << "coalesced" << events.coalesced() << "of" << events.size() << "events,"
+                      << events.shortLived() << "short lived windows";
+        if (events.stats().grows)
+            warning() << "event arena grew" << events.stats().grows << "times to hold" << events.stats().bytes << "bytes";
+        events.clear();
+    } else if (!mEventsScheduled) {
+        warning() << "deferring" << events.pending() << "events";
+        mEventsScheduled = true;
+        EventLoop::eventLoop()->callLater([this]() {
+                mEventsScheduled = false;
+                processXCBEVents();
+            });
+    }
+    // clients destroyed in this pass go away together
+    Client::reap();
+    // all property changes seen in this pass go out together
+    Client::refreshProperties();
+    // handlers may have read replies while waiting on something else
+    mReplies.process();
+    // polling for replies reads the socket too, any events that came along
+    // are in xcb's queue now where the reader, asleep on the socket, won't
+    // look for them on its own
+    if (mReader.isRunning())
+        mReader.kick();
+    flush();
+}
+
+void WindowManager::scheduleFlush()
+{
+    ++mFlushStats.scheduled;
+    if (mFlushPending) {
+        ++mFlushStats.coalesced;
+        return;
+    }
+    mFlushPending = true;
+    if (mFlushQueued)
+        return;
+    mFlushQueued = true;
+    EventLoop::eventLoop()->callLater([this]() {
+            mFlushQueued = false;
+            if (mFlushPending)
+                flush();
+        });
+}
+
+void WindowManager::flush()
+{
+    mFlushPending = false;
+    ++mFlushStats.flushes;
     xcb_flush(mConn);
+    if (mSwitchStart) {
+        const uint64_t elapsed = RoundTrips::now() - mSwitchStart;
+        mSwitchStart = 0;
+        ++mSwitchStats.switches;
+        mSwitchStats.last = elapsed;
+        mSwitchStats.max = std::max(mSwitchStats.max, elapsed);
+        mSwitchStats.total += elapsed;
+    }
+}
+
+void WindowManager::workspaceActivated(Workspace *workspace, uint64_t start)
+{
+    const int screenNumber = workspace->screenNumber();
+    const int idx = mScreens.at(screenNumber).workspaces.indexOf(workspace);
+    xcb_ewmh_set_current_desktop(mEwmhConn, screenNumber, std::max(idx, 0));
+    // back to back switches count from the first one
+    if (!mSwitchStart)
+        mSwitchStart = start;
+    scheduleFlush();
 }
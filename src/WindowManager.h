@@ -2,11 +2,20 @@
 #define WINDOWMANAGER_H
 
 #include "Client.h"
+#include "Errors.h"
+#include "EventBatch.h"
+#include "EventDispatcher.h"
+#include "EventReader.h"
 #include "JavaScript.h"
 #include "Keybindings.h"
 #include "Rect.h"
+#include "Replies.h"
+#include "RoundTrips.h"
+#include "Upgrade.h"
+#include "WindowRegistry.h"
 #include "Workspace.h"
 #include <rct/List.h>
+#include <rct/Set.h>
 #include <memory>
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
@@ -44,7 +53,13 @@ public:
     xcb_visualtype_t* visualForScreen(unsigned int screen) const;
     enum { AllScreens = -1 };
     int preferredScreen() const { return mPreferredScreenIndex; }
-    int screenNumber(xcb_window_t root) const;
+    int screenNumber(xcb_window_t root) const
+    {
+        const WindowRegistry::Entry entry = mWindows.find(root);
+        return entry.kind == WindowRegistry::RootWindow ? entry.screen : -1;
+    }
+    WindowRegistry& windows() { return mWindows; }
+    const WindowRegistry& windows() const { return mWindows; }
     int screenCount() const { return mScreens.size(); }
     const List<Workspace*> & workspaces(int screenNumber) const { return mScreens.at(screenNumber).workspaces; }
 
@@ -53,8 +68,8 @@ public:
     xkb_context* xkbContext() const { return mXkb.ctx; }
     xkb_keymap* xkbKeymap() const { return mXkb.keymap; }
     xkb_state* xkbState() const { return mXkb.state; }
-    void updateXkbState(xcb_xkb_state_notify_event_t* state);
-    void updateXkbMap(xcb_xkb_map_notify_event_t* map);
+    void updateXkbState(const xcb_xkb_state_notify_event_t* state);
+    void updateXkbMap(const xcb_xkb_map_notify_event_t* map);
     String keycodeToString(xcb_keycode_t code);
     xkb_keysym_t keycodeToKeysym(xcb_keycode_t code);
 
@@ -89,6 +104,7 @@ public:
 
     JavaScript& js() { return mJS; }
     bool shouldRestart() const { return mRestart; }
+    bool shouldUpgrade() const { return mUpgrade; }
     int exitCode() const { return mExitCode; }
     Workspace *activeWorkspace(int screenNumber)
     {
@@ -101,23 +117,73 @@ public:
         assert(screenNumber >= 0 && screenNumber < mScreens.size());
         mScreens.at(screenNumber).activeWorkspace = workspace;
     }
+    // called by Workspace::activate() once the switch is queued up, start is
+    // when it began (RoundTrips::now())
+    void workspaceActivated(Workspace *workspace, uint64_t start);
+    bool grabOnSwitch() const { return mGrabOnSwitch; }
+    void setGrabOnSwitch(bool grab) { mGrabOnSwitch = grab; }
+
+    // workspace switches, from activate() until the requests are flushed
+    struct SwitchStats {
+        SwitchStats()
+            : switches(0), last(0), max(0), total(0)
+        {}
+
+        int switches;
+        uint64_t last, max, total; // us
+    };
+    const SwitchStats& switchStats() const { return mSwitchStats; }
     void restart()
     {
         mRestart = true;
         EventLoop::eventLoop()->quit();
     }
 
+    // hands our state to a fresh exec of the binary, see Upgrade
+    void upgrade();
+    // runs the config again against the clients we have, keeping the
+    // connection, atoms, keymap, frames and workspaces
+    bool softRestart(String *err);
+
     void quit(int status = 0)
     {
         mExitCode = status;
         EventLoop::eventLoop()->quit();
     }
 
+    EventDispatcher& dispatcher() { return mDispatcher; }
+    Replies& replies() { return mReplies; }
+    Errors& errors() { return mErrors; }
+
+    // windows that asked to be mapped and are waiting for their attributes.
+    // One that is destroyed or withdrawn in the meantime never gets managed
+    void expectManage(xcb_window_t window) { mPendingManage.insert(window); }
+    void cancelManage(xcb_window_t window) { mPendingManage.remove(window); }
+    bool takeManage(xcb_window_t window) { return mPendingManage.remove(window); }
+
+    // requests go out once at the end of the event loop iteration, flush()
+    // is for the rare case where they can't wait that long
+    void scheduleFlush();
+    void flush();
+    struct FlushStats {
+        FlushStats()
+            : scheduled(0), coalesced(0), flushes(0)
+        {}
+
+        int scheduled, coalesced, flushes;
+    };
+    const FlushStats& flushStats() const { return mFlushStats; }
+
     void processXCBEVents();
 private:
+    enum { EventTimeSlice = 10 }; // ms
+    EventBatch::Priority eventPriority(const xcb_generic_event_t *event) const;
+    void registerHandlers();
+
     bool install();
     bool isRunning();
-    bool manage();
+    bool manage(const Upgrade *upgrade);
+    void restore(const Upgrade &upgrade);
 
 private:
     struct Xkb {
@@ -133,7 +199,7 @@ private:
     xcb_ewmh_connection_t* mEwmhConn;
     struct Screen {
         Screen()
-            : screen(0), visual(0), activeWorkspace(0)
+            : screen(0), visual(0), activeWorkspace(0), reusedWorkspaces(-1)
         {}
 
         xcb_screen_t *screen;
@@ -141,12 +207,29 @@ private:
         Rect rect;
         List<Workspace*> workspaces;
         Workspace *activeWorkspace;
+        // how many of the workspaces the config has asked for again during a
+        // soft restart, -1 otherwise
+        int reusedWorkspaces;
     };
 
     List<Screen> mScreens;
+    WindowRegistry mWindows;
     int mPreferredScreenIndex;
     uint8_t mXkbEvent;
     xcb_key_symbols_t* mSyms;
+    EventBatch mEventBatch;
+    EventDispatcher mDispatcher;
+    Replies mReplies;
+    Errors mErrors;
+    Set<xcb_window_t> mPendingManage;
+    bool mEventsScheduled;
+    bool mUseReaderThread;
+    EventReader mReader;
+    bool mFlushPending, mFlushQueued;
+    FlushStats mFlushStats;
+    bool mGrabOnSwitch;
+    uint64_t mSwitchStart; // 0 unless a switch is waiting for the flush
+    SwitchStats mSwitchStats;
     xcb_timestamp_t mTimestamp;
     JavaScript mJS;
     Keybindings mBindings;
@@ -160,7 +243,7 @@ private:
 
     SocketServer mServer;
     int mExitCode;
-    bool mRestart;
+    bool mRestart, mUpgrade;
 
     static WindowManager *sInstance;
 };
@@ -213,19 +296,17 @@ public:
     ServerGrabScope(xcb_connection_t* conn)
         : mConn(conn)
     {
-        xcb_void_cookie_t cookie = xcb_grab_server(mConn);
-        if (xcb_request_check(mConn, cookie)) {
-            error() << "Unable to grab server";
-            abort();
-        }
+        WindowManager::instance()->errors().expect(xcb_grab_server(mConn), [](const xcb_generic_error_t*) {
+                error() << "Unable to grab server";
+                abort();
+            });
     }
     ~ServerGrabScope()
     {
-        xcb_void_cookie_t cookie = xcb_ungrab_server(mConn);
-        if (xcb_request_check(mConn, cookie)) {
-            error() << "Unable to ungrab server";
-            abort();
-        }
+        WindowManager::instance()->errors().expect(xcb_ungrab_server(mConn), [](const xcb_generic_error_t*) {
+                error() << "Unable to ungrab server";
+                abort();
+            });
     }
 
 private:
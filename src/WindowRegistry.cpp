@@ -0,0 +1,16 @@
+#include "WindowRegistry.h"
+#include <assert.h>
+
+WindowRegistry::WindowRegistry()
+{
+    // room for a busy desktop without rehashing
+    mEntries.reserve(4096);
+}
+
+void WindowRegistry::insert(xcb_window_t window, Kind kind, Client *client, int screen)
+{
+    assert(window != XCB_NONE);
+    assert(kind != None);
+    assert((kind == RootWindow) == !client);
+    mEntries[window] = Entry(kind, client, screen);
+}
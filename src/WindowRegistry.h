@@ -0,0 +1,64 @@
+#ifndef WINDOWREGISTRY_H
+#define WINDOWREGISTRY_H
+
+#include <rct/Hash.h>
+#include <xcb/xcb.h>
+
+class Client;
+
+// Every window nwm knows about, so that handlers can resolve the windows in
+// an event with a single lookup: client windows, the frames we put around
+// them, windows we created ourselves and the roots.
+class WindowRegistry
+{
+public:
+    enum Kind {
+        None,
+        ClientWindow,
+        FrameWindow,
+        OwnedWindow,
+        RootWindow
+    };
+
+    struct Entry {
+        Entry()
+            : kind(None), client(0), screen(-1)
+        {}
+        Entry(Kind k, Client *c, int s)
+            : kind(k), client(c), screen(s)
+        {}
+
+        Kind kind;
+        Client *client;
+        int screen;
+    };
+
+    WindowRegistry();
+
+    void insert(xcb_window_t window, Kind kind, Client *client, int screen);
+    void remove(xcb_window_t window) { mEntries.remove(window); }
+    void clear() { mEntries.clear(); }
+
+    Entry find(xcb_window_t window) const
+    {
+        const auto it = mEntries.find(window);
+        return it == mEntries.end() ? Entry() : it->second;
+    }
+
+    // the client a window belongs to, be it the client window or its frame
+    Client *client(xcb_window_t window) const { return find(window).client; }
+    Client *client(xcb_window_t window, Kind kind) const
+    {
+        const Entry entry = find(window);
+        return entry.kind == kind ? entry.client : 0;
+    }
+    // the screen of a root, client or frame window, -1 if unknown
+    int screen(xcb_window_t window) const { return find(window).screen; }
+
+    int size() const { return mEntries.size(); }
+
+private:
+    Hash<xcb_window_t, Entry> mEntries;
+};
+
+#endif
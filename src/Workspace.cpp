@@ -5,7 +5,7 @@
 #include <stdlib.h>
 
 Workspace::Workspace(int screenNo, const Rect& rect, const String& name)
-    : mRect(rect), mName(name), mScreenNumber(screenNo)
+    : mRect(rect), mName(name), mScreenNumber(screenNo), mFocusLost(false), mHideMode(Client::HideUnmap), mDirty(false)
 {
     // error() << screenNo << rect;
 }
@@ -16,7 +16,11 @@ Workspace::~Workspace()
 
 void Workspace::setRect(const Rect& rect)
 {
+    if (rect == mRect)
+        return;
     mRect = rect;
+    if (mLayoutEngine.isNative())
+        invalidateLayout();
 }
 
 void Workspace::updateFocus(Client *client)
@@ -24,50 +28,53 @@ void Workspace::updateFocus(Client *client)
     assert(client);
     if (client->noFocus())
         return;
-    // find it in our list
-    const auto it = mClients.find(client);
-    assert(it != mClients.end());
-    if (it == mClients.begin()) {
-        // already focused, nothing to do
-        return;
-    }
-    mClients.erase(it);
-    mClients.prepend(client);
+    assert(mClients.contains(client));
+    mClients.moveToFront(client);
 #warning should this tell WindowManager which client is the focused one?
 }
 
 void Workspace::deactivate()
 {
     for (Client *client : mClients) {
-        client->unmap();
+        client->hide();
     }
 }
 
 void Workspace::activate()
 {
-    WindowManager::instance()->activateWorkspace(this);
-    // map all clients in the stacking order
-    Client *client = 0;
-    auto it = mClients.crbegin();
-    const auto end = mClients.crend();
-    while (it != end) {
-        client = *it;
-        client->map();
-        ++it;
+    WindowManager *wm = WindowManager::instance();
+    const uint64_t start = RoundTrips::now();
+    Workspace *previous = wm->activeWorkspace(mScreenNumber);
+    wm->activateWorkspace(this);
+    // before anything is shown so that nothing shows up in the wrong place
+    if (mDirty)
+        relayout();
+    {
+        // all of it goes out in one go, under a grab if asked to so that
+        // nothing gets drawn halfway through
+        std::unique_ptr<ServerGrabScope> grab;
+        if (wm->grabOnSwitch())
+            grab.reset(new ServerGrabScope(wm->connection()));
+        // ours come up before the old ones go away so the root never shows
+        // through, least recently focused first like they were stacked
+        auto it = mClients.rbegin();
+        const auto end = mClients.rend();
+        while (it != end) {
+            (*it)->show();
+            ++it;
+        }
+        if (previous && previous != this)
+            previous->deactivate();
     }
-    if (client)
-        client->focus();
+    refocus();
+    wm->workspaceActivated(this, start);
 }
 
 void Workspace::notifyRaised(Client *client)
 {
     warning() << "raised" << client->className();
-    auto it = mClients.find(client);
-    assert(it != mClients.end());
-    if (it != mClients.begin()) {
-        mClients.erase(it);
-        mClients.prepend(client);
-    }
+    assert(mClients.contains(client));
+    mClients.moveToFront(client);
 }
 
 void Workspace::raise(RaiseMode mode)
@@ -75,44 +82,18 @@ void Workspace::raise(RaiseMode mode)
     if (mClients.isEmpty())
         return;
 
-    int pos = 0;
+    Client *client = 0;
     switch (mode) {
     case Next:
-        pos = 1;
+        client = mClients.next(mClients.first());
         break;
     case Last:
-        pos = -1;
+        client = mClients.last();
         break;
     }
-    if (!pos) {
-        // nothing to do
-        return;
-    }
-    int cur = 0;
-    if (pos > 0) {
-        auto it = mClients.begin();
-        while (it != mClients.end()) {
-            if (cur == pos) {
-                (*it)->raise();
-                (*it)->focus();
-                return;
-            }
-            ++cur;
-            ++it;
-        }
-    } else {
-        pos = abs(pos) - 1;
-        assert(pos >= 0);
-        auto it = mClients.end();
-        while (it != mClients.begin()) {
-            --it;
-            if (cur == pos) {
-                (*it)->raise();
-                (*it)->focus();
-                return;
-            }
-            ++cur;
-        }
+    if (client) {
+        client->raise();
+        client->focus();
     }
 }
 
@@ -134,33 +115,128 @@ void Workspace::addClient(Client *client)
         assert(!mClients.contains(client));
         mClients.append(client);
         if (WindowManager::instance()->activeWorkspace(mScreenNumber) == this) {
-            client->map();
+            client->show();
         } else {
-            client->unmap();
+            client->hide();
         }
     }
 }
+void Workspace::layout(Client *client)
+{
+    assert(client->mWorkspace == this);
+    if (!mTileOrder.contains(client))
+        mTileOrder.append(client);
+    client->mLayoutPending = true;
+    if (!isActive()) {
+        mDirty = true;
+        return;
+    }
+    if (mLayoutEngine.isNative()) {
+        tile();
+        return;
+    }
+    client->mLayoutPending = false;
+    WindowManager::instance()->js().onLayout(client);
+    warning() << "laid out at" << client->rect();
+}
+
+void Workspace::tile()
+{
+    // every tiled client moves when one comes or goes, so all of them in one
+    // pass. Floating ones are only placed when they show up, after that
+    // they stay where they were put
+    List<Client*> clients;
+    clients.reserve(mTileOrder.size());
+    for (Client *client : mTileOrder) {
+        if (!client->isMovable() || client->mLayoutPending)
+            clients.append(client);
+        client->mLayoutPending = false;
+    }
+    mLayoutEngine.apply(mRect, clients);
+}
+
+void Workspace::relayout()
+{
+    mDirty = false;
+    if (mLayoutEngine.isNative()) {
+        tile();
+        return;
+    }
+    // whatever was laid out already stays where it is, it may have been
+    // moved since
+    for (Client *client : mClients) {
+        if (client->mLayoutPending)
+            layout(client);
+    }
+}
+
+void Workspace::invalidateLayout()
+{
+    if (isActive()) {
+        relayout();
+    } else {
+        mDirty = true;
+    }
+}
+
+void Workspace::forget(Client *client)
+{
+    client->mLayoutPending = false;
+    if (mTileOrder.remove(client) && mLayoutEngine.isNative())
+        invalidateLayout();
+}
+
 void Workspace::onClientDestroyed(Client *client)
 {
-    auto it = mClients.find(client);
-    if (it == mClients.end())
+    if (!mClients.contains(client)) {
+        forget(client);
         return;
-    const bool hadFocus = (it == mClients.begin());
-    mClients.erase(it);
+    }
+    const bool hadFocus = (mClients.first() == client);
+    mClients.remove(client);
+    forget(client);
     if (hadFocus) {
-        // focus the first available one in our list
-        for (Client *client : mClients) {
-            if (!client->noFocus()) {
-                client->focus();
-                return;
-            }
+        if (Client::isReaping()) {
+            mFocusLost = true;
+        } else {
+            refocus();
+        }
+    }
+}
+
+void Workspace::onClientDoomed(Client *client)
+{
+    if (!mClients.contains(client))
+        return;
+    // Client::reap() picks the next one once the whole batch is gone
+    if (mClients.first() == client)
+        mFocusLost = true;
+    mClients.remove(client);
+    forget(client);
+}
+
+void Workspace::settleFocus()
+{
+    if (!mFocusLost)
+        return;
+    mFocusLost = false;
+    refocus();
+}
+
+void Workspace::refocus()
+{
+    // focus the first available one in our list
+    for (Client *client : mClients) {
+        if (!client->noFocus()) {
+            client->focus();
+            return;
         }
-        // No window to focus, focus the root window instead
-        WindowManager *wm = WindowManager::instance();
-        wm->updateCurrentScreen(mScreenNumber);
-        const xcb_window_t root = screen()->root;
-        xcb_set_input_focus(wm->connection(), XCB_INPUT_FOCUS_PARENT, root, wm->timestamp());
-        // error() << "Setting input focus to root" << root;
-        xcb_ewmh_set_active_window(wm->ewmhConnection(), mScreenNumber, root);
     }
+    // No window to focus, focus the root window instead
+    WindowManager *wm = WindowManager::instance();
+    wm->updateCurrentScreen(mScreenNumber);
+    const xcb_window_t root = screen()->root;
+    xcb_set_input_focus(wm->connection(), XCB_INPUT_FOCUS_PARENT, root, wm->timestamp());
+    // error() << "Setting input focus to root" << root;
+    xcb_ewmh_set_active_window(wm->ewmhConnection(), mScreenNumber, root);
 }
@@ -2,9 +2,10 @@
 #define WORKSPACE_H
 
 #include "Client.h"
+#include "IntrusiveList.h"
+#include "LayoutEngine.h"
 #include "Rect.h"
 #include <rct/String.h>
-#include <rct/LinkedList.h>
 #include <rct/Set.h>
 #include <memory>
 
@@ -16,7 +17,10 @@ public:
 
     void setRect(const Rect& rect);
 
+    // shows this workspace in place of the active one on its screen
     void activate();
+    // hides our clients, activate() does this for the workspace it replaces
+    void deactivate();
 
     int screenNumber() const { return mScreenNumber; }
     xcb_screen_t *screen() const;
@@ -24,39 +28,70 @@ public:
     void addClient(Client *client);
     void removeClient(Client *client);
 
+    // Runs the JS layout for the client right away if we're shown, otherwise
+    // marks us dirty and it runs once we're activated. Clients that were
+    // laid out already aren't asked about again on activation
+    void layout(Client *client);
+    bool isDirty() const { return mDirty; }
+
+    // tiles our clients natively unless it's in Script mode. Call
+    // invalidateLayout() after changing it
+    LayoutEngine &layoutEngine() { return mLayoutEngine; }
+    // lays everything out again now if we're shown, otherwise on activate
+    void invalidateLayout();
+
     void updateFocus(Client *client = 0);
     void onClientDestroyed(Client *client);
+    // takes a client that's going away at the end of the batch out of the
+    // focus order right away
+    void onClientDoomed(Client *client);
+    // focuses the next client if the focused one went away in the batch
+    // Client::reap() just deleted
+    void settleFocus();
 
     enum RaiseMode { Next, Last };
     void raise(RaiseMode mode);
     void notifyRaised(Client *client);
 
+    // ordered by focus, most recent first
+    typedef IntrusiveList<Client, &Client::mFocusNode> FocusList;
+    const FocusList &clients() const { return mClients; }
+    // the idx'th most recently focused client, 0 if there are fewer
+    Client *client(int idx) const { return mClients.at(idx); }
+
+    // how clients that don't say otherwise are hidden while we're not active
+    Client::HideMode hideMode() const { return mHideMode; }
+    void setHideMode(Client::HideMode mode) { mHideMode = mode == Client::HideDefault ? Client::HideUnmap : mode; }
+
     String name() const { return mName; }
     Rect rect() const { return mRect; }
 
     inline bool isActive() const;
+    // focuses the most recently focused client that takes focus, or the root
+    void refocus();
 private:
-    void deactivate();
+    void relayout();
+    void tile();
+    void forget(Client *client);
 
 private:
     Rect mRect;
     String mName;
     // ordered by focus
-    LinkedList<Client *> mClients;
+    FocusList mClients;
     const int mScreenNumber;
+    bool mFocusLost;
+    Client::HideMode mHideMode;
+    bool mDirty;
+    LayoutEngine mLayoutEngine;
+    // clients that take part in the layout, in the order they arrived
+    List<Client*> mTileOrder;
 };
 
 inline void Workspace::removeClient(Client *client)
 {
-    auto it = mClients.begin();
-    const auto end = mClients.cend();
-    while (it != end) {
-        if (*it == client) {
-            mClients.erase(it);
-            return;
-        }
-        ++it;
-    }
+    mClients.remove(client);
+    forget(client);
 }
 
 #endif
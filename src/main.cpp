@@ -2,25 +2,40 @@
 #include <rct/EventLoop.h>
 #include <rct/Log.h>
 #include <rct/Path.h>
+#include <rct/Rct.h>
 #include <rct/Value.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 
 int main(int argc, char** argv)
 {
     int code;
     while (true) {
-        EventLoop::SharedPtr loop = std::make_shared<EventLoop>();
-        loop->init(EventLoop::MainEventLoop|EventLoop::EnableSigIntHandler);
+        bool upgrade;
+        {
+            EventLoop::SharedPtr loop = std::make_shared<EventLoop>();
+            loop->init(EventLoop::MainEventLoop|EventLoop::EnableSigIntHandler);
 
-        WindowManager manager;
-        if (!manager.init(argc, argv)) {
-            return 1;
-        }
-        loop->exec();
-        cleanupLogging();
+            WindowManager manager;
+            if (!manager.init(argc, argv)) {
+                return 1;
+            }
+            loop->exec();
+            cleanupLogging();
 
-        if (!manager.shouldRestart()) {
-            code = manager.exitCode();
-            break;
+            upgrade = manager.shouldUpgrade();
+            if (!upgrade && !manager.shouldRestart()) {
+                code = manager.exitCode();
+                break;
+            }
+        }
+        if (upgrade) {
+            // the X connection is gone by now, the new binary picks up the
+            // state from NWM_UPGRADE_FD
+            execv(Rct::executablePath().constData(), argv);
+            // restart in place instead, that still gets the state
+            fprintf(stderr, "Unable to exec %s: %s\n", Rct::executablePath().constData(), strerror(errno));
         }
     }
     return code;